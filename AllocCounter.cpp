@@ -0,0 +1,31 @@
+﻿#include "AllocCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local uint64_t t_allocations = 0;
+}
+
+uint64_t AllocCounter::count()
+{
+    return t_allocations;
+}
+
+// 数组形式与 nothrow 形式的默认实现都转调这两个函数，无需单独替换
+void *operator new(std::size_t size)
+{
+    ++t_allocations;
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
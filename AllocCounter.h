@@ -0,0 +1,14 @@
+﻿#ifndef ALLOCCOUNTER_H
+#define ALLOCCOUNTER_H
+
+#include <cstdint>
+
+// 堆分配计数：AllocCounter.cpp 替换全局 operator new / delete，按线程累计分配次数。
+// 只链接进控制台工具（模拟器），用于验证结算循环热身后不再向堆申请内存；游戏本体不链接
+namespace AllocCounter
+{
+// 当前线程累计的 operator new 调用次数（单调递增，取两次读数之差）
+uint64_t count();
+}
+
+#endif // ALLOCCOUNTER_H
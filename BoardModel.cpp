@@ -0,0 +1,148 @@
+﻿#include "BoardModel.h"
+
+#include <algorithm>
+#include <utility>
+
+BoardModel::BoardModel(const QStringList &names, QObject *parent)
+    : QAbstractListModel(parent), m_names(names)
+{
+}
+
+int BoardModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return 0;
+    return int(m_codes.size());
+}
+
+QVariant BoardModel::data(const QModelIndex &index, int role) const
+{
+    const int i = index.row();
+    if (i < 0 || i >= int(m_codes.size())) return QVariant();
+    switch (role) {
+    case TileColorRole: {
+        const uint8_t code = m_codes[size_t(i)];
+        const QString name = code < m_names.size() ? m_names[code] : QString();
+        return name.isEmpty() ? QString("transparent") : name;
+    }
+    case TileCodeRole:          return int(m_codes[size_t(i)]);
+    case PendingActivationRole: return m_pending.test(i);
+    case DropOffsetRole:        return m_dropOffset[size_t(i)];
+    case RevisionRole:          return m_revision[size_t(i)];
+    default:                    return QVariant();
+    }
+}
+
+QHash<int, QByteArray> BoardModel::roleNames() const
+{
+    QHash<int, QByteArray> names;
+    names[TileColorRole] = "tileColor";
+    names[TileCodeRole] = "tileCode";
+    names[PendingActivationRole] = "pendingActivation";
+    names[DropOffsetRole] = "dropOffset";
+    names[RevisionRole] = "revision";
+    return names;
+}
+
+void BoardModel::resetBoard(const TileGrid &board)
+{
+    const size_t size = size_t(board.size());
+    if (size != m_codes.size() || board.columns() != m_columns) {
+        beginResetModel();
+        m_columns = board.columns();
+        m_codes.assign(board.data(), board.data() + size);
+        m_pending.resize(int(size));
+        m_nextPending.resize(int(size));
+        m_dropOffset.assign(size, 0);
+        m_dropCells.clear();
+        m_revision.assign(size, 0);
+        endResetModel();
+        return;
+    }
+    m_pending.clear();
+    for (int i : m_dropCells) m_dropOffset[size_t(i)] = 0;
+    m_dropCells.clear();
+    for (size_t i = 0; i < size; ++i) {
+        m_codes[i] = board.data()[i];
+        m_revision[i]++;
+    }
+    if (size > 0) emit dataChanged(index(0), index(int(size) - 1));
+}
+
+void BoardModel::publish(const TileGrid &board, const std::vector<int> &changed)
+{
+    if (size_t(board.size()) != m_codes.size() || board.columns() != m_columns) {
+        resetBoard(board);
+        return;
+    }
+    for (int i : changed) {
+        m_codes[size_t(i)] = board.data()[i];
+        m_revision[size_t(i)]++;
+    }
+    emitRanges(changed, QVector<int>{TileColorRole, TileCodeRole, RevisionRole});
+}
+
+void BoardModel::setPendingActivations(const std::vector<int> &cells)
+{
+    m_nextPending.clear();
+    for (int i : cells) {
+        if (i >= 0 && i < m_nextPending.size()) m_nextPending.set(i);
+    }
+    m_changed.clear();
+    m_pending.forEachDifference(m_nextPending, [this](int i) { m_changed.push_back(i); });
+    std::swap(m_pending, m_nextPending);
+    emitRanges(m_changed, QVector<int>{PendingActivationRole});
+}
+
+void BoardModel::setDrops(const std::vector<DropMove> &drops, const std::vector<int> &spawned)
+{
+    resetDropOffsets();
+    const int size = int(m_dropOffset.size());
+    for (const DropMove &d : drops) {
+        const int i = d.toRow * m_columns + d.col;
+        if (i < 0 || i >= size) continue;
+        m_dropOffset[size_t(i)] = d.toRow - d.fromRow;
+        m_dropCells.push_back(i);
+    }
+    // 补位的方块在列顶之上依次排开，整列一起下落同样的行数
+    m_spawnCount.assign(size_t(m_columns), 0);
+    for (int i : spawned) {
+        if (i >= 0 && i < size) m_spawnCount[size_t(i % m_columns)]++;
+    }
+    for (int i : spawned) {
+        if (i < 0 || i >= size) continue;
+        m_dropOffset[size_t(i)] = m_spawnCount[size_t(i % m_columns)];
+        m_dropCells.push_back(i);
+    }
+    m_changed.insert(m_changed.end(), m_dropCells.begin(), m_dropCells.end());
+    std::sort(m_changed.begin(), m_changed.end());
+    m_changed.erase(std::unique(m_changed.begin(), m_changed.end()), m_changed.end());
+    emitRanges(m_changed, QVector<int>{DropOffsetRole});
+}
+
+void BoardModel::clearDrops()
+{
+    resetDropOffsets();
+    std::sort(m_changed.begin(), m_changed.end());
+    emitRanges(m_changed, QVector<int>{DropOffsetRole});
+}
+
+void BoardModel::resetDropOffsets()
+{
+    m_changed.clear();
+    for (int i : m_dropCells) {
+        m_dropOffset[size_t(i)] = 0;
+        m_changed.push_back(i);
+    }
+    m_dropCells.clear();
+}
+
+void BoardModel::emitRanges(const std::vector<int> &cells, const QVector<int> &roles)
+{
+    size_t begin = 0;
+    while (begin < cells.size()) {
+        size_t end = begin;
+        while (end + 1 < cells.size() && cells[end + 1] == cells[end] + 1) ++end;
+        emit dataChanged(index(cells[begin]), index(cells[end]), roles);
+        begin = end + 1;
+    }
+}
@@ -0,0 +1,68 @@
+﻿#ifndef BOARDMODEL_H
+#define BOARDMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QByteArray>
+#include <QStringList>
+#include <vector>
+
+#include "CellBitset.h"
+#include "TileGrid.h"
+#include "Match3Engine.h"
+
+// 棋盘的 QML 列表模型：一行对应一个格子（行优先，下标 = row * columns + col），
+// 由 GameBoard 在每次下发棋盘时更新，改动按连续下标区间合并成 dataChanged，
+// Repeater 只刷新受影响的委托，不再逐格调用 tileAt() 或维护字符串键的 tileMap
+class BoardModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        TileColorRole = Qt::UserRole + 1,   // QML 名称（颜色名 / Rocket_1 / Bomb ...），空格为 "transparent"
+        TileCodeRole,                       // 紧凑编码 TileCode
+        PendingActivationRole,              // 该格的道具已被波及，将在回放中依次激活
+        DropOffsetRole,                     // 下落动画中该格方块起落点之上的行数（补位从棋盘上方落入），否则为 0
+        RevisionRole                        // 该格每次被下发时递增；委托据此复位被动画改写过的外观
+    };
+
+    // names 为编码 -> QML 名称表（GameBoard::tileNames()）
+    explicit BoardModel(const QStringList &names, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    int columns() const { return m_columns; }
+
+    // 整盘替换：尺寸变化时重置模型，否则所有格子发一次 dataChanged
+    void resetBoard(const TileGrid &board);
+    // 增量：changed 为已改动（或需复位外观）的格子下标，升序
+    void publish(const TileGrid &board, const std::vector<int> &changed);
+    // 回放中尚未激活的道具格子；传空表示清除
+    void setPendingActivations(const std::vector<int> &cells);
+    // 下落动画开始：drops 为下落轨迹，spawned 为补入的格子（按列从棋盘上方落入）
+    void setDrops(const std::vector<DropMove> &drops, const std::vector<int> &spawned);
+    // 下落已落盘：偏移全部归零
+    void clearDrops();
+
+private:
+    // 把升序下标合并成连续区间逐段发出 dataChanged
+    void emitRanges(const std::vector<int> &cells, const QVector<int> &roles);
+    // 把 m_dropCells 的偏移归零并记入 m_changed
+    void resetDropOffsets();
+
+    QStringList m_names;
+    int m_columns = 0;
+    std::vector<uint8_t> m_codes;
+    CellBitset m_pending;
+    CellBitset m_nextPending;           // setPendingActivations 的暂存，与 m_pending 交换复用
+    std::vector<int> m_changed;         // 本次有变化的下标，跨次复用
+    std::vector<int> m_dropOffset;
+    std::vector<int> m_dropCells;       // 偏移非 0 的格子
+    std::vector<int> m_spawnCount;      // setDrops 的暂存：每列补入的格子数
+    std::vector<int> m_revision;
+};
+
+#endif // BOARDMODEL_H
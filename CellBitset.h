@@ -0,0 +1,66 @@
+﻿#ifndef CELLBITSET_H
+#define CELLBITSET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "RunScanner.h"
+
+// 按格子下标（TileGrid::index）的稠密位集：每格一位，测试/置位/清除 O(1)，
+// 整体清零按 64 位字进行，置位格子可按下标升序遍历。用于代替以坐标为键的散列集合
+class CellBitset
+{
+public:
+    CellBitset() = default;
+    explicit CellBitset(int cells) { resize(cells); }
+
+    // 调整为 cells 个格子并全部清零
+    void resize(int cells) {
+        m_cells = cells;
+        m_words.assign(size_t(RunScanner::wordsFor(cells)), 0);
+    }
+    int size() const { return m_cells; }
+
+    bool test(int i) const { return (m_words[size_t(i >> 6)] >> (i & 63)) & 1; }
+    void set(int i) { m_words[size_t(i >> 6)] |= uint64_t(1) << (i & 63); }
+    void reset(int i) { m_words[size_t(i >> 6)] &= ~(uint64_t(1) << (i & 63)); }
+    // 置位并返回置位前的值
+    bool testAndSet(int i) {
+        uint64_t &w = m_words[size_t(i >> 6)];
+        const uint64_t bit = uint64_t(1) << (i & 63);
+        const bool was = (w & bit) != 0;
+        w |= bit;
+        return was;
+    }
+    void clear() {
+        for (uint64_t &w : m_words) w = 0;
+    }
+    bool any() const {
+        for (uint64_t w : m_words) {
+            if (w) return true;
+        }
+        return false;
+    }
+
+    // 按下标升序对每个置位格子调用 fn(index)
+    template <typename Fn>
+    void forEach(Fn &&fn) const {
+        for (size_t k = 0; k < m_words.size(); ++k) {
+            for (uint64_t w = m_words[k]; w; w &= w - 1) fn(int(k << 6) + RunScanner::lowestBit(w));
+        }
+    }
+    // 按下标升序对与 other 取值不同的格子调用 fn(index)；两者尺寸需一致
+    template <typename Fn>
+    void forEachDifference(const CellBitset &other, Fn &&fn) const {
+        for (size_t k = 0; k < m_words.size(); ++k) {
+            for (uint64_t w = m_words[k] ^ other.m_words[k]; w; w &= w - 1) fn(int(k << 6) + RunScanner::lowestBit(w));
+        }
+    }
+
+private:
+    int m_cells = 0;
+    std::vector<uint64_t> m_words;
+};
+
+#endif // CELLBITSET_H
@@ -0,0 +1,107 @@
+﻿#include "ColorBitboard.h"
+#include "MatchFinder.h"
+#include "RunScanner.h"
+
+namespace {
+using RunScanner::lowestBit;
+
+// 从 pos 开始连续的 1 的个数
+inline int onesFrom(uint64_t m, int pos)
+{
+    const uint64_t rest = ~(m >> pos);
+    return rest ? lowestBit(rest) : 64 - pos;
+}
+}
+
+void ColorBitboard::update(const TileGrid &board)
+{
+    if (!m_synced || board.rows() != m_rows || board.columns() != m_columns || board.version() < m_syncedVersion) {
+        m_rows = board.rows();
+        m_columns = board.columns();
+        m_rowMasks.assign(size_t(TileColorCount) * size_t(m_rows), 0);
+        m_colMasks.assign(size_t(TileColorCount) * size_t(m_columns), 0);
+        for (int r = 0; r < m_rows; ++r) rebuildRow(board, r);
+        for (int c = 0; c < m_columns; ++c) rebuildColumn(board, c);
+    } else if (board.version() != m_syncedVersion) {
+        // 每次写入都同时标记所在行和列，因此只需重建版本戳变化过的行/列
+        for (int r = 0; r < m_rows; ++r) {
+            if (board.rowVersion(r) > m_syncedVersion) rebuildRow(board, r);
+        }
+        for (int c = 0; c < m_columns; ++c) {
+            if (board.colVersion(c) > m_syncedVersion) rebuildColumn(board, c);
+        }
+    }
+    m_syncedVersion = board.version();
+    m_synced = true;
+}
+
+void ColorBitboard::rebuildRow(const TileGrid &board, int row)
+{
+    uint64_t masks[TileColorCount] = {};
+    const uint8_t *data = board.rowData(row);
+    for (int c = 0; c < m_columns; ++c) {
+        if (tileIsColor(data[c])) masks[data[c] - Tile_Red] |= uint64_t(1) << c;
+    }
+    for (int k = 0; k < TileColorCount; ++k) m_rowMasks[size_t(k) * size_t(m_rows) + size_t(row)] = masks[k];
+}
+
+void ColorBitboard::rebuildColumn(const TileGrid &board, int col)
+{
+    uint64_t masks[TileColorCount] = {};
+    for (int r = 0; r < m_rows; ++r) {
+        const uint8_t t = board.at(r, col);
+        if (tileIsColor(t)) masks[t - Tile_Red] |= uint64_t(1) << r;
+    }
+    for (int k = 0; k < TileColorCount; ++k) m_colMasks[size_t(k) * size_t(m_columns) + size_t(col)] = masks[k];
+}
+
+void ColorBitboard::appendLineRuns(const TileGrid &board, bool horizontal, int line, std::vector<MatchRun> &out) const
+{
+    // 某位为起点的三连：m & (m>>1) & (m>>2)；再去掉前一格同色的位置，只保留连续段起点
+    uint64_t starts = 0;
+    for (int k = 0; k < TileColorCount; ++k) {
+        const uint64_t m = horizontal ? m_rowMasks[size_t(k) * size_t(m_rows) + size_t(line)]
+                                      : m_colMasks[size_t(k) * size_t(m_columns) + size_t(line)];
+        starts |= m & (m >> 1) & (m >> 2) & ~(m << 1);
+    }
+    while (starts) {
+        const int pos = lowestBit(starts);
+        starts &= starts - 1;
+        const uint8_t color = horizontal ? board.at(line, pos) : board.at(pos, line);
+        const uint64_t m = horizontal ? rowMask(color, line) : colMask(color, line);
+        out.push_back({color, horizontal, line, pos, onesFrom(m, pos)});
+    }
+}
+
+void ColorBitboard::findBombCenters(std::vector<int> &out) const
+{
+    // 以中心所在行为基准：L1/L2 = 左侧 1/2 格同色，R1/R2 = 右侧，U1/U2、D1/D2 = 上下方同列同色。
+    // 12 种 T/L 偏移模式合并为：
+    //   T 横：L1&R1 且 (U1&U2 | D1&D2)
+    //   T 竖：U1&D1 且 (L1&L2 | R1&R2)
+    //   L  ：(L1&L2 | R1&R2) 且 (U1&U2 | D1&D2)
+    for (int r = 0; r < m_rows; ++r) {
+        uint64_t centers = 0;
+        for (int k = 0; k < TileColorCount; ++k) {
+            const uint64_t *rowsOfColor = m_rowMasks.data() + size_t(k) * size_t(m_rows);
+            const uint64_t c = rowsOfColor[r];
+            if (!c) continue;
+            const uint64_t u1 = r >= 1 ? rowsOfColor[r - 1] : 0;
+            const uint64_t u2 = r >= 2 ? rowsOfColor[r - 2] : 0;
+            const uint64_t d1 = r + 1 < m_rows ? rowsOfColor[r + 1] : 0;
+            const uint64_t d2 = r + 2 < m_rows ? rowsOfColor[r + 2] : 0;
+            const uint64_t l1 = c << 1, l2 = c << 2, r1 = c >> 1, r2 = c >> 2;
+
+            const uint64_t horiz = l1 & r1;
+            const uint64_t arm   = (l1 & l2) | (r1 & r2);
+            const uint64_t vert  = u1 & d1;
+            const uint64_t leg   = (u1 & u2) | (d1 & d2);
+            centers |= c & ((horiz & leg) | (vert & arm) | (arm & leg));
+        }
+        while (centers) {
+            const int col = lowestBit(centers);
+            centers &= centers - 1;
+            out.push_back(r * m_columns + col);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+﻿#ifndef COLORBITBOARD_H
+#define COLORBITBOARD_H
+
+#include <cstdint>
+#include <vector>
+
+#include "TileGrid.h"
+
+struct MatchRun;
+
+// 按颜色分层的位棋盘：每种颜色每行一个 64 位掩码（第 c 位 = 第 c 列），
+// 同时保存转置后的每列掩码（第 r 位 = 第 r 行），支持最大 64x64 的棋盘。
+// 连续段和 T/L 炸弹形状都用整行的移位与按位与一次求出，不再逐格比较。
+// 与 MatchFinder 一样依据 TileGrid 的行/列版本戳增量同步
+class ColorBitboard
+{
+public:
+    static const int MaxSide = 64;
+
+    static bool supports(int rows, int columns) {
+        return rows > 0 && columns > 0 && rows <= MaxSide && columns <= MaxSide;
+    }
+
+    // 同步到棋盘当前内容：首次或尺寸变化时全量重建，否则只重建版本戳变化过的行/列
+    void update(const TileGrid &board);
+
+    int rows() const { return m_rows; }
+    int columns() const { return m_columns; }
+
+    // 某颜色（Tile_Red..Tile_Brown）在第 row 行 / 第 col 列的掩码
+    uint64_t rowMask(uint8_t color, int row) const { return m_rowMasks[slot(color, row, m_rows)]; }
+    uint64_t colMask(uint8_t color, int col) const { return m_colMasks[slot(color, col, m_columns)]; }
+
+    // 从一条线（行或列）的掩码中提取长度 >= 3 的连续段，按起点升序追加到 out
+    // horizontal 为真时 line 为行号，否则为列号
+    void appendLineRuns(const TileGrid &board, bool horizontal, int line, std::vector<MatchRun> &out) const;
+
+    // T/L 形炸弹中心（与 GameBoard 原 12 种偏移模式等价），按行优先顺序输出 TileGrid 下标
+    void findBombCenters(std::vector<int> &out) const;
+
+private:
+    static size_t slot(uint8_t color, int line, int lines) {
+        return size_t(color - Tile_Red) * size_t(lines) + size_t(line);
+    }
+    void rebuildRow(const TileGrid &board, int row);
+    void rebuildColumn(const TileGrid &board, int col);
+
+    int m_rows = 0;
+    int m_columns = 0;
+    bool m_synced = false;
+    uint32_t m_syncedVersion = 0;
+    std::vector<uint64_t> m_rowMasks;   // [颜色][行]
+    std::vector<uint64_t> m_colMasks;   // [颜色][列]
+};
+
+#endif // COLORBITBOARD_H
@@ -1,1536 +1,757 @@
 ﻿#include "GameBoard.h"
-#include <QRandomGenerator>
 #include <QDebug>
 #include <QVariant>
+#include <QVariantMap>
 #include <QList>
 #include <QVector>
 #include <QPoint>
 #include <QTimer>
+#include <QFile>
+#include <QIODevice>
+#include <QRandomGenerator>
 
-#include <QPoint>
-// 实现 qHash 重载
-inline uint qHash(const QPoint &point, uint seed = 0) {
-    // 使用一个简单的哈希函数，通常是组合 x 和 y 坐标
-    return qHash(point.x(), seed) ^ qHash(point.y(), seed);
+#include "RunScanner.h"
+#include "Trace.h"
+
+namespace {
+// 激活批次中相邻两层的建议启动间隔：同层并行，下一层在上一层动画开始后启动
+const int ChainWaveIntervalMs = 300;
+// 提示搜索的最大层数：实际深度由时间预算决定
+const int HintSearchDepth = 4;
+// 撤销历史保存的局面数（含起点）
+const int HistoryCapacity = 32;
+
+#ifdef MATCH3_TRACE
+// 追踪缓冲由事件循环定时取出，在主线程统一格式化输出
+const int TraceFlushIntervalMs = 100;
+
+void traceToDebug(const char *line)
+{
+    qDebug().noquote() << line;
+}
+#endif
 }
 
-GameBoard::GameBoard(QObject *parent, int rows, int columns)
-    : QObject(parent), m_comboCnt(0), m_rows(rows), m_columns(columns), m_score(0), m_comboPending(false)
+GameBoard::GameBoard(QObject *parent, int rows, int columns, MatchFinder::Backend backend, quint64 seed)
+    : QObject(parent), m_comboCnt(0), m_rows(rows), m_columns(columns), m_score(0),
+      m_engine(rows, columns, backend, seed), m_history(HistoryCapacity)
 {
     m_step = m_init_step;
     m_availableColors = {"red", "green", "blue", "yellow", "purple", "brown"};
+#ifndef QT_NO_DEBUG
+    // 调试构建下每次增量检测都与全盘扫描比对
+    m_engine.setCrossCheck(true);
+#endif
+#ifdef MATCH3_TRACE
+    Trace::setSink(traceToDebug);
+    QTimer *traceFlush = new QTimer(this);
+    connect(traceFlush, &QTimer::timeout, this, []() { Trace::drain(); });
+    traceFlush->start(TraceFlushIntervalMs);
+#endif
+    if (backend == MatchFinder::Backend_Simd) {
+        M3_TRACE(Cat_Board, Level_Info, "MatchFinder: SIMD backend, isa %d (0 scalar, 1 SSE2, 2 AVX2)",
+                 int(RunScanner::activeIsa()));
+    }
+    M3_TRACE(Cat_Board, Level_Info, "GameBoard: seed 0x%08x%08x", int(seed >> 32), int(seed & 0xFFFFFFFFu));
+    m_model = new BoardModel(tileNames(), this);
+    m_engine.setLatencyRecorder(&m_latency);
+    SolverConfig solver;
+    solver.maxDepth = HintSearchDepth;
+    m_solver.setConfig(solver);
+    m_engine.resetCounters(m_step);
     initializeBoard();
 }
 
+// 仅用于挑选默认种子；对局中的随机数全部来自引擎内的 GameRng
+quint64 GameBoard::randomSeed()
+{
+    return QRandomGenerator::system()->generate64();
+}
+
+void GameBoard::setSeed(quint64 seed)
+{
+    m_engine.reseed(seed);
+    emit seedChanged(seed);
+    resetGame();
+}
+
 void GameBoard::initializeBoard() {
     // 只进行棋盘初始化，不执行掉落或三消逻辑
-    m_board.resize(m_rows);
-
-    // 循环生成棋盘，直到没有三消
-    do {
-        for (int r = 0; r < m_rows; ++r) {
-            m_board[r].resize(m_columns);
-            for (int c = 0; c < m_columns; ++c) {
-                m_board[r][c] = getRandomColor();
-            }
-        }
-    } while (!findMatches(0, 0, 0, 0, false).isEmpty()); // 检查是否有匹配，如果有匹配则重新生成棋盘
+    abortReplay();
+    m_engine.newBoard();
+    m_board = m_engine.board();
 
-    emit boardChanged();  // 刷新棋盘
+    publishBoard();  // 刷新棋盘
+    resetHistory();
 }
 
-// 补新方块
-void GameBoard::fillNewTiles() {
-    int rows = m_board.size();
-    int cols = m_board[0].size();
-
-    // 对每一列分别处理，跳过不可移动(背景)格子
-    for (int c = 0; c < cols; ++c) {
-        int r = rows - 1;
-        while (r >= 0) {
-            // 跳过不可移动(块)位置，找到一个连续的可移动区段
-            if (!m_board[r][c].isEmpty() && !isMovable(m_board[r][c])) {
-                r--;
-                continue;
-            }
+void GameBoard::resetHistory()
+{
+    m_history.reset(m_engine);
+    emit historyChanged();
+}
 
-            int segmentBottom = r;
-            int segmentTop = r;
-            while (segmentTop >= 0 && (m_board[segmentTop][c].isEmpty() || isMovable(m_board[segmentTop][c]))) {
-                // 只要是空或者可移动就继续
-                segmentTop--;
-            }
-            segmentTop++;
-
-            // 在区段内，从顶部到底部填充空位
-            for (int rr = segmentTop; rr <= segmentBottom; ++rr) {
-                if (m_board[rr][c].isEmpty()) {
-                    QPoint pt(rr, c);
-                    // 如果该位置有挂起的道具激活，不要覆盖，留空等待激活
-                    if (m_pendingActivations.contains(pt)) {
-                        qDebug() << "fillNewTiles: skip filling pending activation at" << pt;
-                        continue; // 保持为空，等待激活
-                    }
-                    m_board[rr][c] = getRandomColor();
-                }
-            }
+void GameBoard::recordHistory()
+{
+    m_history.push(m_engine);
+    emit historyChanged();
+}
 
-            r = segmentTop - 1;
-        }
-    }
+void GameBoard::restoreFromEngine()
+{
+    // 快照之间只有少数格子不同，按 diff 下发
+    m_board = m_engine.board();
+    syncCounters(m_engine.counters());
+    flushBoardDiff();
+    emit historyChanged();
+}
+
+bool GameBoard::undo()
+{
+    if (replaying() || !m_history.undo(m_engine)) return false;
+    restoreFromEngine();
+    return true;
+}
+
+bool GameBoard::redo()
+{
+    if (replaying() || !m_history.redo(m_engine)) return false;
+    restoreFromEngine();
+    return true;
+}
+
+bool GameBoard::setBlastRadius(int type, int radius)
+{
+    if (replaying()) return false;
+    return m_engine.setBlastRadius(type, radius);
 }
 
 QString GameBoard::tileAt(int row, int col) const {
     if (row < 0 || row >= m_rows || col < 0 || col >= m_columns)
         return "transparent";
-    return m_board[row][col];
+    return tileName(m_board.at(row, col));
+}
+
+QStringList GameBoard::tileNames() const {
+    QStringList names;
+    names.reserve(Tile_CodeCount);
+    for (int code = 0; code < Tile_CodeCount; ++code) names.append(tileName(uint8_t(code)));
+    return names;
 }
 
 void GameBoard::trySwap(int r1, int c1, int r2, int c2) {
-    qDebug() << "尝试交换:" << r1 << c1 << "->" << r2 << c2;
+    M3_TRACE(Cat_Replay, Level_Debug, "trySwap (%d,%d) -> (%d,%d)", r1, c1, r2, c2);
 
-    if (!isValidSwap(r1, c1, r2, c2)) {
-        qDebug() << "无效交换";
+    // 上一步的动画尚未回放完时不接受新的交换
+    if (replaying() || !m_engine.isValidSwap(r1, c1, r2, c2)) {
+        M3_TRACE(Cat_Replay, Level_Debug, "invalid swap (%d,%d) -> (%d,%d)", r1, c1, r2, c2);
         emit invalidSwap(r1, c1, r2, c2);   // 只告诉 QML 播动画
         return;
     }
 
+    m_swapRequested = LatencyRecorder::now();
+    m_moveStart = m_swapRequested;
     emit swapAnimationRequested(r1, c1, r2, c2);        // 播放请求交换动画
 }
 
-// qml交换动画完成之后调用此函数
-Q_INVOKABLE void GameBoard::finalizeSwap(int r1, int c1, int r2, int c2, bool isRecursion){
-    qDebug() << "finalizeSwap called:" << QPoint(r1,c1) << "->" << QPoint(r2,c2) << "isRecursion:" << isRecursion;
-
-    // 若标记挂起但队列已空，自动解除，避免后续阻塞
-    if (m_comboPending && m_pendingActivations.isEmpty()) {
-        qDebug() << "finalizeSwap: comboPending true but no pendingActivations, auto-reset";
-        m_comboPending = false;
-    }
-    if (m_comboPending) {
-        qDebug() << "finalizeSwap: combo pending, skipping to avoid re-entry";
-        return;
-    }
-
-    bool stepDeducted = false;
-    QString preA = ""; QString preB = "";
-    if (!isRecursion) {
-        preA = m_board[r1][c1];
-        preB = m_board[r2][c2];
-        qDebug() << "finalizeSwap: pre-swap values:" << QPoint(r1,c1) << preA << QPoint(r2,c2) << preB << "isProp:" << isProp(preA) << isProp(preB);
-        std::swap(m_board[r1][c1], m_board[r2][c2]);
-        qDebug() << "finalizeSwap: post-swap values:" << QPoint(r1,c1) << m_board[r1][c1] << QPoint(r2,c2) << m_board[r2][c2];
-        emit boardChanged();
-    }
-
-    // 1) 首先判定：双道具组合（只触发组合效果，绝不触发单体）
-    const bool aIsProp = isProp(preA);
-    const bool bIsProp = isProp(preB);
-    if (aIsProp && bIsProp) {
-        qDebug() << "finalizeSwap: both sides are props, trigger combo only. preA:" << preA << "preB:" << preB;
-        m_comboPending = true;
-        if (!isRecursion && !stepDeducted) { updateStep(-1); stepDeducted = true; }
-        // 标记本次组合的两个参与点，后续组合效果与调度层都会跳过它们
-        markComboParticipants(r1, c1, r2, c2);
-
-        // 超级+超级
-        if (preA == SuperItem && preB == SuperItem) {
-            schedulePropEffect(r2, c2, Combo_SuperSuperType, QString(), 0);
-            return;
-        }
-        // 超级+炸弹
-        if ((preA == SuperItem && preB == Bomb) || (preB == SuperItem && preA == Bomb)) {
-            schedulePropEffect(r2, c2, Combo_SuperBombType, QString(), 0);
-            return;
-        }
-        // 超级+火箭
-        if ((preA == SuperItem && isRocket(preB)) || (preB == SuperItem && isRocket(preA))) {
-            schedulePropEffect(r2, c2, Combo_SuperRocketType, QString(), 0);
-            return;
-        }
-        // 火箭+火箭
-        if (isRocket(preA) && isRocket(preB)) {
-            schedulePropEffect(r2, c2, Combo_RocketRocketType, QString(), 0);
-            return;
-        }
-        // 炸弹+炸弹
-        if (isBomb(preA) && isBomb(preB)) {
-            schedulePropEffect(r2, c2, Combo_BombBombType, QString(), 0);
-            return;
-        }
-        // 炸弹+火箭（记录火箭类型）
-        if ((isBomb(preA) && isRocket(preB)) || (isRocket(preA) && isBomb(preB))) {
-            int rocketType = isRocket(preA) ? (preA==Rocket_UpDown?Rocket_UpDownType:Rocket_LeftRightType)
-                                            : (preB==Rocket_UpDown?Rocket_UpDownType:Rocket_LeftRightType);
-            schedulePropEffect(r2, c2, Combo_BombRocketType, QString::number(rocketType), 0);
-            return;
-        }
-        // 未覆盖的道具组合，直接返回避免单体触发
-        return;
-    }
-
-    // 2) 其次判定：道具 + 普通颜色（只触发单体对应效果）
-    if ((aIsProp && !bIsProp) || (!aIsProp && bIsProp)) {
-        qDebug() << "finalizeSwap: prop + color, trigger single effect. preA:" << preA << "preB:" << preB;
-        m_comboPending = true;
-        if (!isRecursion && !stepDeducted) { updateStep(-1); stepDeducted = true; }
-        if (aIsProp) {
-            if (preA == Rocket_UpDown)      schedulePropEffect(r2, c2, Rocket_UpDownType, preB, 0);
-            else if (preA == Rocket_LeftRight) schedulePropEffect(r2, c2, Rocket_LeftRightType, preB, 0);
-            else if (preA == Bomb)          schedulePropEffect(r2, c2, BombType, preB, 0);
-            else if (preA == SuperItem && !preB.isEmpty()) schedulePropEffect(r2, c2, SuperItemType, preB, 0);
-        } else {
-            if (preB == Rocket_UpDown)      schedulePropEffect(r1, c1, Rocket_UpDownType, preA, 0);
-            else if (preB == Rocket_LeftRight) schedulePropEffect(r1, c1, Rocket_LeftRightType, preA, 0);
-            else if (preB == Bomb)          schedulePropEffect(r1, c1, BombType, preA, 0);
-            else if (preB == SuperItem && !preA.isEmpty()) schedulePropEffect(r1, c1, SuperItemType, preA, 0);
-        }
-        emit boardChanged();
-        return;
-    }
-
-    // 3) 再判定：普通匹配（三消/四消/五消），有效行动扣步
-    auto matches = findMatches(r1, c1, r2, c2, true);
-    if (!matches.isEmpty()) {
-        m_comboCnt++;
-        if (!isRecursion && !stepDeducted) { updateStep(-1); stepDeducted = true; }
-        QVariantList variantMatches;
-        for (const QPoint &pt : matches) { variantMatches.append(QVariant::fromValue(pt)); }
-        // 记录本次交换产生的道具集合，等待前端匹配动画播放完毕后再触发生成
-        m_reservedRocketMatches = rocketMatches;
-        m_reservedBombMatches = bombMatches;
-        m_reservedSuperItemMatches = superItemMatches;
-        m_reservedPropsPending = true;
-        emit matchAnimationRequested(variantMatches);
-        if (m_comboCnt > 1) emit comboChanged(m_comboCnt);
-        return;
-    }
-
-    // 4) 无效交换：回滚且不扣步
-    m_comboCnt = 0;
-    if (!isRecursion) {
-        std::swap(m_board[r1][c1], m_board[r2][c2]);
-        emit rollbackSwap(r1, c1, r2, c2);
-        emit boardChanged();
-    }
+QVariantList GameBoard::availableMoves() const
+{
+    const std::vector<MoveHint> &moves = m_engine.availableMoves();
+    QVariantList list;
+    list.reserve(int(moves.size()));
+    for (const MoveHint &m : moves) {
+        QVariantMap item;
+        item.insert("r1", m.r1);
+        item.insert("c1", m.c1);
+        item.insert("r2", m.r2);
+        item.insert("c2", m.c2);
+        item.insert("cleared", m.cleared);
+        item.insert("propType", m.propType);
+        list.append(item);
+    }
+    return list;
+}
+
+SolverResult GameBoard::searchBestMove(int budgetMs)
+{
+    if (replaying()) return SolverResult();
+    SolverConfig config = m_solver.config();
+    config.budgetMs = budgetMs > 0 ? budgetMs : 0;
+    m_solver.setConfig(config);
+    return m_solver.solve(m_engine);
 }
 
-// 在 schedulePropEffect 执行时，清除 m_comboPending 标志以允许后续组合
-void GameBoard::schedulePropEffect(int row, int col, int type, const QString &color, int delayMs)
+QVariantMap GameBoard::bestMove(int budgetMs)
+{
+    const SolverResult result = searchBestMove(budgetMs);
+    QVariantMap item;
+    if (!result.found) return item;
+    item.insert("r1", result.move.r1);
+    item.insert("c1", result.move.c1);
+    item.insert("r2", result.move.r2);
+    item.insert("c2", result.move.c2);
+    item.insert("value", result.value);
+    item.insert("depth", result.depth);
+    M3_TRACE(Cat_Replay, Level_Debug, "bestMove: depth %d, %d nodes, %d table hits",
+             result.depth, int(result.nodes), int(result.tableHits));
+    return item;
+}
+
+bool GameBoard::playBestMove(int budgetMs)
 {
-    qDebug() << "schedulePropEffect: scheduling" << type << "at" << QPoint(row,col) << "delayMs:" << delayMs << "color:" << color;
-    QPoint pt(row, col);
+    const SolverResult result = searchBestMove(budgetMs);
+    if (!result.found) return false;
+    trySwap(result.move.r1, result.move.c1, result.move.r2, result.move.c2);
+    return true;
+}
 
-    // 若该点是组合参与者且 type 属于单体（1~4），则跳过，防止组合完成后再次单独激活
-    if (m_comboParticipants.contains(pt) && type >= 1 && type <= 4) {
-        qDebug() << "schedulePropEffect: skip single effect at combo participant" << pt << "type:" << type;
-        return;
-    }
+QVariantMap GameBoard::latencyStats() const
+{
+    QVariantMap stats;
+    for (int p = 0; p < LatencyRecorder::PhaseCount; ++p) {
+        const LatencyRecorder::Phase phase = LatencyRecorder::Phase(p);
+        const LatencyRecorder::Summary s = m_latency.summary(phase);
+        if (s.count == 0) continue;
+        QVariantMap item;
+        item.insert("count", double(s.count));
+        item.insert("meanMs", s.mean / 1e6);
+        item.insert("minMs", double(s.min) / 1e6);
+        item.insert("p50Ms", double(s.p50) / 1e6);
+        item.insert("p90Ms", double(s.p90) / 1e6);
+        item.insert("p99Ms", double(s.p99) / 1e6);
+        item.insert("maxMs", double(s.max) / 1e6);
+        stats.insert(LatencyRecorder::phaseName(phase), item);
+    }
+    return stats;
+}
+
+void GameBoard::resetLatencyStats()
+{
+    m_latency.reset();
+}
 
-    if (m_pendingActivations.contains(pt)) {
-        qDebug() << "schedulePropEffect: already pending at" << pt << ", skip";
-        return;
-    }
-    m_pendingActivations.insert(pt);
-
-    QTimer::singleShot(delayMs, this, [this, row, col, type, color]() {
-        // 执行前先移除该点的 pending，防止残留导致后续阻塞
-        m_pendingActivations.remove(QPoint(row, col));
-        qDebug() << "schedulePropEffect: executing (emit propEffect)" << type << "at" << QPoint(row,col) << "color:" << color;
-        emit propEffect(row, col, type, color);
-    });
+void GameBoard::setLatencyTrace(int maxSpans)
+{
+    m_latency.setTraceCapacity(maxSpans);
 }
 
-QString GameBoard::chooseNearbyColor(int row, int col) const
+bool GameBoard::saveLatencyTrace(const QString &path) const
 {
-    // 优先从上下左右四个格子随机选一个常规颜色（避免越界）
-    QVector<QString> candidates;
-    const QPoint neigh[4] = { QPoint(-1,0), QPoint(1,0), QPoint(0,-1), QPoint(0,1) };
-    for (int i = 0; i < 4; ++i) {
-        int r = row + neigh[i].x();
-        int c = col + neigh[i].y();
-        if (r < 0 || r >= m_rows || c < 0 || c >= m_columns) continue;
-        QString v = m_board[r][c];
-        if (isColor(v)) candidates.append(v);
-    }
-    if (!candidates.isEmpty()) {
-        int idx = QRandomGenerator::global()->bounded(candidates.size());
-        qDebug() << "chooseNearbyColor: picked neighbor color" << candidates[idx] << "around" << QPoint(row,col);
-        return candidates[idx];
+    const std::string json = m_latency.chromeTrace();
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "saveLatencyTrace: cannot open" << path;
+        return false;
     }
+    const bool ok = file.write(json.data(), qint64(json.size())) == qint64(json.size());
+    file.close();
+    return ok;
+}
 
-    // 回退策略：全盘随机选一种颜色（排除道具/空）
-    QVector<QString> allColors;
-    for (int r = 0; r < m_rows; ++r) {
-        for (int c = 0; c < m_columns; ++c) {
-            QString v = m_board[r][c];
-            if (isColor(v)) allColors.append(v);
-        }
-    }
-    if (!allColors.isEmpty()) {
-        int idx = QRandomGenerator::global()->bounded(allColors.size());
-        qDebug() << "chooseNearbyColor: fallback pick from board" << allColors[idx];
-        return allColors[idx];
-    }
+// qml交换动画完成之后调用此函数：由引擎一次结算到稳定，再按动画节奏回放
+Q_INVOKABLE void GameBoard::finalizeSwap(int r1, int c1, int r2, int c2, bool isRecursion){
+    M3_TRACE(Cat_Replay, Level_Debug, isRecursion ? "finalizeSwap (%d,%d) -> (%d,%d), recursion" : "finalizeSwap (%d,%d) -> (%d,%d)", r1, c1, r2, c2);
 
-    // 最后回退到可用颜色列表中的第一个
-    qDebug() << "chooseNearbyColor: no color found nearby or on board, using default";
-    return m_availableColors.isEmpty() ? QString() : m_availableColors[0];
-}
+    // 连锁三消已由引擎在同一次结算中处理，递归调用不再需要
+    if (isRecursion || replaying()) return;
 
-// 修改 rocketEffectTriggered：在清除行/列时，若遇到其他道具（炸弹/超级/火箭），将调度其激活（延迟 500ms）
-void GameBoard::rocketEffectTriggered(int row, int col, int type)
-{
-    // 重要：动画完成进入逻辑阶段，解除组合挂起状态
-    m_comboPending = false;
-    // 确保清除延迟激活标记，避免重复调度阻塞
-    m_pendingActivations.remove(QPoint(row, col));
-    m_comboParticipants.remove(QPoint(row, col));
-
-    qDebug() << "rocketEffectTriggered: start" << QPoint(row,col) << "type" << type;
-
-    // 先消耗触发该效果的火箭，避免其在后续掉落/匹配流程中再次被激活
-    if (row >= 0 && row < m_rows && col >= 0 && col < m_columns) {
-        if (!m_board[row][col].isEmpty()) {
-            qDebug() << "rocketEffectTriggered: consume activator at" << QPoint(row,col) << "value=" << m_board[row][col];
-        }
-        m_board[row][col] = "";
-        m_pendingActivations.remove(QPoint(row,col));
-    }
+    const uint64_t accepted = LatencyRecorder::now();
+    if (m_swapRequested) m_latency.record(LatencyRecorder::Phase_SwapAnimation, m_swapRequested, accepted);
+    m_swapRequested = 0;
+    if (!m_moveStart) m_moveStart = accepted;
 
-    QVector<QPoint> clearedNow; // 立即清除的普通颜色格子
-    // 对被调度激活的道具位置我们不在此刻清空，交由 schedulePropEffect 在稍后执行
-    if(type == Rocket_UpDownType)
+    m_log.clear();
+    bool played;
     {
-        // 清列
-        for (int r = 0; r < m_rows; ++r) {
-            // 跳过触发来源自身位置
-            if (r == row) continue; // FIX: 原为 (r == row && c == col)
-            QString v = m_board[r][col];
-            if (v.isEmpty()) continue;
-
-            // 若该位置处于待激活集合中，则跳过，避免组合后再次单体触发
-            if (m_pendingActivations.contains(QPoint(r, col))) continue;
-
-            if (isBomb(v)) {
-                schedulePropEffect(r, col, BombType, QString(), 500);
-            } else if (isRocket(v)) {
-                int rocketType = (v == Rocket_UpDown) ? Rocket_UpDownType : Rocket_LeftRightType;
-                schedulePropEffect(r, col, rocketType, QString(), 500);
-            } else if (v == SuperItem) {
-                // 给超级道具选择一个附近颜色作为参数
-                QString choose = chooseNearbyColor(r, col);
-                schedulePropEffect(r, col, SuperItemType, choose, 500);
-            } else {
-                // 普通颜色，直接清空
-                m_board[r][col] = "";
-                clearedNow.append(QPoint(r, col));
-            }
-        }
+        LatencyRecorder::Scope timing(&m_latency, LatencyRecorder::Phase_Resolve);
+        played = m_engine.playSwap(r1, c1, r2, c2, m_log);
     }
-    else if(type == Rocket_LeftRightType)
-    {
-        // 清行
-        for (int c = 0; c < m_columns; ++c) {
-            // 跳过触发来源自身位置
-            if (c == col) continue; // FIX: 原为 (r == row && c == col)
-            QString v = m_board[row][c];
-            if (v.isEmpty()) continue;
-
-            if (m_pendingActivations.contains(QPoint(row, c))) continue;
-
-            if (isBomb(v)) {
-                schedulePropEffect(row, c, BombType, QString(), 500);
-            } else if (isRocket(v)) {
-                int rocketType = (v == Rocket_UpDown) ? Rocket_UpDownType : Rocket_LeftRightType;
-                schedulePropEffect(row, c, rocketType, QString(), 500);
-            } else if (v == SuperItem) {
-                QString choose = chooseNearbyColor(row, c);
-                schedulePropEffect(row, c, SuperItemType, choose, 500);
-            } else {
-                m_board[row][c] = "";
-                clearedNow.append(QPoint(row, c));
-            }
-        }
+    if (!played) {
+        // 动画期间棋盘已不允许该交换：直接让前端复位
+        flushBoardDiff();
+        finishMove();
+        emit rollbackSwap(r1, c1, r2, c2);
+        return;
     }
+    // 换回的无效交换不改变局面，不进历史
+    if (m_log.back().kind != EngineEvent::Event_Rollback) recordHistory();
+    startReplay(m_log, 0);
+}
 
-    qDebug() << "rocketEffectTriggered: clearedNow count" << clearedNow.size();
-    updateScore(clearedNow.size() * 10);
-    // 单体火箭激活次数
-    addStatAt(6);
-    emit boardChanged();
-    processDrop();
+void GameBoard::finishMove()
+{
+    if (!m_moveStart) return;
+    m_latency.record(LatencyRecorder::Phase_Settle, m_moveStart, LatencyRecorder::now());
+    m_moveStart = 0;
 }
 
-// 修改 bombEffectTriggered：在清除圆形区域时，若遇到其他道具调度其激活
-void GameBoard::bombEffectTriggered(int row, int col) {
-    // 重要：动画完成进入逻辑阶段，解除组合挂起状态
-    m_comboPending = false;
-    m_pendingActivations.remove(QPoint(row, col));
-    m_comboParticipants.remove(QPoint(row, col));
+// ---------------------------------------------------------------------------
+// 事件回放
+// ---------------------------------------------------------------------------
 
-    int radius = 2;  // 半径为 2 的圆形区域（含中心）
+void GameBoard::startReplay(EventLog &log, int firstPos)
+{
+    m_replay.swap(log);
+    m_replayPos = firstPos;
+    m_wait = Wait_None;
+    emit historyChanged();  // 回放期间不可撤销
+    advanceReplay();
+}
 
-    // 同样先消耗触发炸弹本体，避免重复激活
-    if (row >= 0 && row < m_rows && col >= 0 && col < m_columns) {
-        if (!m_board[row][col].isEmpty()) {
-            qDebug() << "bombEffectTriggered: consume activator at" << QPoint(row,col) << "value=" << m_board[row][col];
+void GameBoard::abortReplay()
+{
+    m_replay.clear();
+    m_replayPos = 0;
+    m_batchEnd = 0;
+    m_batchDone.clear();
+    m_wait = Wait_None;
+    m_swapRequested = 0;
+    m_moveStart = 0;
+    m_model->setPendingActivations(std::vector<int>());
+    m_model->clearDrops();
+}
+
+void GameBoard::advanceReplay()
+{
+    m_wait = Wait_None;
+    updatePendingActivations();
+    while (replaying()) {
+        const EngineEvent &ev = m_replay[size_t(m_replayPos)];
+        switch (ev.kind) {
+        case EngineEvent::Event_Swap:
+            applyEvent(ev);
+            ++m_replayPos;
+            break;
+
+        case EngineEvent::Event_Rollback: {
+            // 无效交换：回滚且不扣步
+            const int r1 = ev.row, c1 = ev.col, r2 = ev.row2, c2 = ev.col2;
+            m_board = ev.board;
+            m_comboCnt = ev.counters.combo;
+            ++m_replayPos;
+            flushBoardDiff();   // 与前面的 Swap 抵消，通常不产生 diff
+            emit rollbackSwap(r1, c1, r2, c2);
+            break;
+        }
+
+        case EngineEvent::Event_Match: {
+            // 等前端匹配动画播放完毕后由 processMatches 落盘
+            const QVariantList matched = cellsToVariant(ev.cells);
+            const int combo = ev.counters.combo;
+            m_wait = Wait_Match;
+            m_waitStart = LatencyRecorder::now();
+            m_comboCnt = combo;
+            flushBoardDiff();
+            emit matchAnimationRequested(matched);
+            if (combo > 1) emit comboChanged(combo);
+            return;
         }
-        m_board[row][col] = "";
-        m_pendingActivations.remove(QPoint(row,col));
-    }
-
-    QVector<QPoint> clearedNow;
-    QVector<QPoint> expected;
 
-    // 先计算期望清除的格子（基于整数平方距离），用于对比调试
-    for (int r = row - radius; r <= row + radius; ++r) {
-        for (int c = col - radius; c <= col + radius; ++c) {
-            if (r >= 0 && r < m_rows && c >= 0 && c < m_columns) {
-                int dr = r - row, dc = c - col;
-                if (dr*dr + dc*dc <= radius*radius) expected.append(QPoint(r,c));
-            }
+        case EngineEvent::Event_Drop: {
+            // 下落后的棋盘先下发，各格的下落行数经模型的 dropOffset 交给委托自行播放下落；
+            // 动画结束后 QML 调用 commitDrop 继续回放
+            applyEvent(ev);
+            m_wait = Wait_Drop;
+            m_waitStart = LatencyRecorder::now();
+            flushBoardDiff();
+            m_model->setDrops(ev.drops, ev.cells);
+            emit dropAnimationRequested(dropsToVariant(ev));
+            return;
         }
-    }
 
-    // 清除圆形范围内的方块（使用整数判断）
-    for (const QPoint &pt : expected) {
-        int r = pt.x();
-        int c = pt.y();
-        // 跳过触发来源自身位置（该炸弹自身已被清空）
-        if (r == row && c == col) continue;
-
-        QString v = m_board[r][c];
-        if (v.isEmpty()) continue;
-
-        // 如果是道具，调度其激活（不立即清空）
-        if (isBomb(v)) {
-            schedulePropEffect(r, c, BombType, QString(), 500);
-        } else if (isRocket(v)) {
-            int rocketType = (v == Rocket_UpDown) ? Rocket_UpDownType : Rocket_LeftRightType;
-            schedulePropEffect(r, c, rocketType, QString(), 500);
-        } else if (v == SuperItem) {
-            QString choose = chooseNearbyColor(r, c);
-            schedulePropEffect(r, c, SuperItemType, choose, 500);
-        } else {
-            m_board[r][c] = "";
-            clearedNow.append(pt);
+        case EngineEvent::Event_Shuffle: {
+            // 无步可走的自动重排：直接落盘
+            const int repairs = ev.meta;
+            applyEvent(ev);
+            ++m_replayPos;
+            flushBoardDiff();
+            emit boardReshuffled(repairs);
+            break;
         }
-    }
 
-    // 记录未被清除但应被清除的位置（理论上应该为空）
-    QVector<QPoint> missed;
-    for (const QPoint &pt : expected) {
-        if (!m_board[pt.x()][pt.y()].isEmpty()) {
-            missed.append(pt);
+        case EngineEvent::Event_Activate:
+            // 引擎已算完整条连锁：整批交给 QML 并行播放，不再逐个往返
+            m_wait = Wait_Activate;
+            emitActivationBatch();
+            return;
         }
     }
 
-    qDebug() << "bombEffectTriggered: bomb at" << QPoint(row,col) << "expected cells:" << expected.size() << "clearedNow:" << clearedNow.size() << "missed:" << missed;
-    if (!missed.isEmpty()) {
-        qDebug() << "bombEffectTriggered: missed positions (should be empty):" << missed;
+    // 回放结束：展示棋盘与引擎一致，连击清零。最后落盘的快照应与引擎棋盘相同，按哈希 O(1) 校验
+    if (!m_replay.empty() && m_board.hash() != m_engine.board().hash()) {
+        M3_TRACE(Cat_Replay, Level_Warn, "replay ended on a board that differs from the engine");
     }
-
-    updateScore(clearedNow.size() * 10);
-    // 单体炸弹激活次数
-    addStatAt(7);
-    emit boardChanged();  // 发出更新棋盘信号
-    processDrop();
+    m_replay.clear();
+    m_replayPos = 0;
+    m_comboCnt = m_engine.counters().combo;
+    m_board = m_engine.board();
+    markBoardDirty();
+    finishMove();
+    emit historyChanged();
 }
 
-// 补充：道具激活后立即查找并处理新產生的三消
-void GameBoard::checkAndProcessNewMatches()
+void GameBoard::applyEvent(const EngineEvent &ev)
 {
-    qDebug() << "checkAndProcessNewMatches: checking for new matches after prop effects";
-    // 这里的查找不需要考虑 r1, c1, r2, c2，因为道具激活后可能在任意位置產生新的三消
-    QVector<QPoint> newMatches = findMatches(0, 0, 0, 0, true);
-    if (!newMatches.isEmpty()) {
-        qDebug() << "checkAndProcessNewMatches: found" << newMatches.size() << "new matched tiles, removing and creating props";
-        removeMatchedTiles(newMatches);
-        // 在移除匹配后，创建由 findMatches 记录的道具（如果有）
-        creatProp();
-        emit boardChanged();
-        // 处理下落（视觉由 QML 播放，随后 QML 调用 commitDrop）
-        processDrop();
-    } else {
-        qDebug() << "checkAndProcessNewMatches: no new matches";
-    }
+    m_board = ev.board;
+    syncCounters(ev.counters);
+    markBoardDirty(&ev);
 }
 
-QString GameBoard::getRandomColor() const {
-    int idx = QRandomGenerator::global()->bounded(m_availableColors.size());
-    return m_availableColors[idx];
-}
+void GameBoard::syncCounters(const EngineCounters &counters)
+{
+    m_comboCnt = counters.combo;
 
-// 修复const问题
-bool GameBoard::isValidSwap(int r1, int c1, int r2, int c2) {
-    // 检查边界
-    if (r1 < 0 || r1 >= m_rows || c1 < 0 || c1 >= m_columns ||
-        r2 < 0 || r2 >= m_rows || c2 < 0 || c2 >= m_columns) {
-        qDebug() << "isValidSwap: out of bounds" << QPoint(r1,c1) << QPoint(r2,c2);
-        return false;
+    if (m_score != counters.score) {
+        m_score = counters.score;
+        emit scoreChanged(m_score);
     }
-
-    // 检查是否相邻
-    if (!((qAbs(r1 - r2) == 1 && c1 == c2) || (qAbs(c1 - c2) == 1 && r1 == r2))) {
-        qDebug() << "isValidSwap: not adjacent" << QPoint(r1,c1) << QPoint(r2,c2);
-        return false;
+    if (m_step != counters.steps) {
+        m_step = counters.steps;
+        emit stepChanged(m_step);
+        if (counters.gameOver) emit gameOver();
     }
-
-    // 检查是否可以移动（不能与空格或背景格子交换）
-    QString a = m_board[r1][c1];
-    QString b = m_board[r2][c2];
-    if (!isMovable(a) || !isMovable(b)) {
-        qDebug() << "isValidSwap: one side not movable or empty" << QPoint(r1,c1) << a << QPoint(r2,c2) << b;
-        return false;
+    bool statsDirty = false;
+    for (int i = 0; i < StatCount; ++i) {
+        if (m_stats[i] != counters.stats[i]) {
+            m_stats[i] = counters.stats[i];
+            statsDirty = true;
+        }
     }
-
-    return true;
+    if (statsDirty) emit statsChanged(stats());
 }
 
-// 判断是否是道具
-bool GameBoard::isProp(QString color)
+void GameBoard::publishBoard()
 {
-    if(color == Rocket_UpDown    ||
-       color == Rocket_LeftRight ||
-       color == Bomb             ||
-       color == SuperItem)
-        return true;
-    else
-        return false;
+    m_publishedBoard = m_board;
+    m_touched.resize(m_board.size());
+    m_model->resetBoard(m_board);
+    emit boardChanged();
 }
 
-QVector<PropTypedef> GameBoard::findRocketMatches(int r1, int c1, int r2, int c2)
+void GameBoard::markBoardDirty(const EngineEvent *ev)
 {
-    rocketMatches.clear();
-
-    struct Match4 { bool horizontal; int line; int start; int end; QString color; };
-    QVector<Match4> matches;
-
-    // 收集横向 4 连
-    for (int r = 0; r < m_rows; ++r) {
-        for (int c = 0; c < m_columns - 3; ++c) {
-            QString color = m_board[r][c];
-            if (!isColor(color)) continue;
-            bool ok = true;
-            for (int i = 1; i < 4; ++i) if (m_board[r][c+i] != color) { ok = false; break; }
-            if (ok) matches.append({true, r, c, c+3, color});
-        }
+    if (ev && m_touched.size() == m_board.size()) {
+        // 编码没变也要复位外观的格子：下落路径（委托随后按 dropOffset 重播下落）、被消除/激活的格子
+        switch (ev->kind) {
+        case EngineEvent::Event_Drop:
+            for (const DropMove &d : ev->drops) {
+                for (int r = d.fromRow; r <= d.toRow; ++r) m_touched.set(m_board.index(r, d.col));
+            }
+            for (int idx : ev->cells) m_touched.set(idx);
+            break;
+        case EngineEvent::Event_Match:
+            for (int idx : ev->cells) m_touched.set(idx);
+            break;
+        case EngineEvent::Event_Activate:
+            for (int idx : ev->cells) m_touched.set(idx);
+            m_touched.set(m_board.index(ev->row, ev->col));
+            break;
+        default:
+            break;
+        }
+    }
+    if (m_diffQueued) return;
+    m_diffQueued = true;
+    QTimer::singleShot(0, this, [this]() { flushBoardDiff(); });
+}
+
+void GameBoard::updatePendingActivations()
+{
+    m_pendingCells.clear();
+    for (int i = m_replayPos; i < int(m_replay.size()); ++i) {
+        const EngineEvent &ev = m_replay[size_t(i)];
+        if (ev.kind == EngineEvent::Event_Activate) m_pendingCells.push_back(m_board.index(ev.row, ev.col));
     }
+    m_model->setPendingActivations(m_pendingCells);
+}
 
-    // 收集纵向 4 连
-    for (int c = 0; c < m_columns; ++c) {
-        for (int r = 0; r < m_rows - 3; ++r) {
-            QString color = m_board[r][c];
-            if (!isColor(color)) continue;
-            bool ok = true;
-            for (int i = 1; i < 4; ++i) if (m_board[r+i][c] != color) { ok = false; break; }
-            if (ok) matches.append({false, c, r, r+3, color});
-        }
+// 提前下发（动画请求之前）后，已排队的回调会发现没有改动而直接返回
+void GameBoard::flushBoardDiff()
+{
+    m_diffQueued = false;
+    if (m_publishedBoard.rows() != m_board.rows() || m_publishedBoard.columns() != m_board.columns()) {
+        publishBoard();
+        return;
     }
-
-    // 对每个匹配，优先使用交换点的显式 membership 判定
-    for (const Match4 &m : matches) {
-        if (m.horizontal) {
-            int row = m.line;
-            int start = m.start, end = m.end;
-            // 如果交换点 r1,c1 在该匹配格子集合内（并且当前颜色匹配），则优先生成在该点
-            if (r1 == row && c1 >= start && c1 <= end && m_board[r1][c1] == m.color) {
-                qDebug() << QString("(%1, %2) 创建竖向火箭(由交换端点1决定)").arg(r1).arg(c1);
-                rocketMatches.append({Rocket_UpDownType, QPoint(r1, c1)});
-            }
-            else if (r2 == row && c2 >= start && c2 <= end && m_board[r2][c2] == m.color) {
-                qDebug() << QString("(%1, %2) 创建竖向火箭(由交换端点2决定)").arg(r2).arg(c2);
-                rocketMatches.append({Rocket_UpDownType, QPoint(r2, c2)});
-            }
-            else {
-                // 自然生成：匹配中点
-                int center = (start + end) / 2; // 对于 4 连，这里为 c+1
-                qDebug() << QString("(%1, %2) 创建竖向火箭(自然生成)").arg(row).arg(center);
-                rocketMatches.append({Rocket_UpDownType, QPoint(row, center)});
-            }
-        } else {
-            int col = m.line;
-            int start = m.start, end = m.end;
-            if (c1 == col && r1 >= start && r1 <= end && m_board[r1][c1] == m.color) {
-                qDebug() << QString("(%1, %2) 创建横向火箭(由交换端点1决定)").arg(r1).arg(c1);
-                rocketMatches.append({Rocket_LeftRightType, QPoint(r1, c1)});
-            }
-            else if (c2 == col && r2 >= start && r2 <= end && m_board[r2][c2] == m.color) {
-                qDebug() << QString("(%1, %2) 创建横向火箭(由交换端点2决定)").arg(r2).arg(c2);
-                rocketMatches.append({Rocket_LeftRightType, QPoint(r2, c2)});
-            }
-            else {
-                int center = (start + end) / 2; // 对于 4 连，这里为 r+1
-                qDebug() << QString("(%1, %2) 创建横向火箭(自然生成)").arg(center).arg(col);
-                rocketMatches.append({Rocket_LeftRightType, QPoint(center, col)});
-            }
-        }
+    const uint8_t *cur = m_board.data();
+    const uint8_t *prev = m_publishedBoard.data();
+    m_changed.clear();
+    for (int i = 0; i < m_board.size(); ++i) {
+        if (cur[i] == prev[i] && !m_touched.test(i)) continue;
+        m_changed.push_back(i);
     }
-
-    return rocketMatches;
+    m_touched.clear();
+    if (m_changed.empty()) return;
+    m_publishedBoard = m_board;
+    m_model->publish(m_board, m_changed);
+    M3_TRACE(Cat_Replay, Level_Debug, "flushBoardDiff: %d cells", int(m_changed.size()));
 }
 
-
-QVector<PropTypedef> GameBoard::findBombMatches()
+void GameBoard::emitActivationBatch()
 {
-    bombMatches.clear();
-
-    // 定义所有 T/L 形的偏移模式（以交点/拐点为中心）
-    const QVector<QVector<QPoint>> patterns = {
-        // T 向上: center, left, right, up1, up2
-        {{0,0},{0,-1},{0,1},{-1,0},{-2,0}},
-        // T 向下
-        {{0,0},{0,-1},{0,1},{1,0},{2,0}},
-        // T 向左
-        {{0,0},{-1,0},{1,0},{0,-1},{0,-2}},
-        // T 向右
-        {{0,0},{-1,0},{1,0},{0,1},{0,2}},
-
-        // L 交点在右上角 (horizontal left leg, vertical down leg)
-        {{0,0},{0,-1},{0,-2},{1,0},{2,0}},
-        // L 交点在左上角 (horizontal right leg, vertical down leg)
-        {{0,0},{0,1},{0,2},{1,0},{2,0}},
-        // L 交点在左下角 (horizontal right leg, vertical up leg)
-        {{0,0},{0,1},{0,2},{-1,0},{-2,0}},
-        // L 交点在右下角 (horizontal left leg, vertical up leg)
-        {{0,0},{0,-1},{0,-2},{-1,0},{-2,0}},
-
-        // 其他 L 变体（转置），以确保覆盖所有 8 种 L 方向
-        {{0,0},{1,0},{2,0},{0,-1},{0,-2}},
-        {{0,0},{1,0},{2,0},{0,1},{0,2}},
-        {{0,0},{-1,0},{-2,0},{0,1},{0,2}},
-        {{0,0},{-1,0},{-2,0},{0,-1},{0,-2}}
-    };
-
-    for (int r = 0; r < m_rows; ++r) {
-        for (int c = 0; c < m_columns; ++c) {
-            QString color = m_board[r][c];
-            if (!isColor(color)) continue;
-            for (const auto &pat : patterns) {
-                bool ok = true;
-                for (const QPoint &off : pat) {
-                    int rr = r + off.x();
-                    int cc = c + off.y();
-                    if (rr < 0 || rr >= m_rows || cc < 0 || cc >= m_columns) { ok = false; break; }
-                    if (m_board[rr][cc] != color) { ok = false; break; }
-                }
-                if (ok) {
-                    bombMatches.append({BombType, QPoint(r, c)});
-                    qDebug() << QString("(%1, %2) %3 匹配炸弹模式").arg(r).arg(c).arg(color);
-                    break; // 一个中心点匹配到任一模式即可
-                }
-            }
+    m_batchBegin = m_replayPos;
+    m_batchEnd = m_replayPos;
+    while (m_batchEnd < int(m_replay.size()) && m_replay[size_t(m_batchEnd)].kind == EngineEvent::Event_Activate) ++m_batchEnd;
+    m_batchDone.assign(size_t(m_batchEnd - m_batchBegin), 0);
+
+    // 事件按 wave 非递减排列；建议启动时间按相对首层的层数计算
+    const int firstWave = m_replay[size_t(m_batchBegin)].wave;
+    QVariantList batch;
+    batch.reserve(m_batchEnd - m_batchBegin);
+    for (int i = m_batchBegin; i < m_batchEnd; ++i) {
+        const EngineEvent &ev = m_replay[size_t(i)];
+        QVariantMap item;
+        item.insert("row", ev.row);
+        item.insert("col", ev.col);
+        item.insert("type", ev.propType);
+        // 炸弹+火箭组合通过 color 传递火箭类型，其余传颜色名（超级道具为目标颜色）
+        item.insert("color", ev.propType == Combo_BombRocketType ? QString::number(ev.meta) : tileName(ev.color));
+        item.insert("wave", ev.wave);
+        item.insert("delayMs", (ev.wave - firstWave) * ChainWaveIntervalMs);
+        batch.append(item);
+    }
+    M3_TRACE(Cat_Replay, Level_Debug, "propBatch: %d activations, waves %d..%d",
+             m_batchEnd - m_batchBegin, firstWave, m_replay[size_t(m_batchEnd - 1)].wave);
+    flushBoardDiff();
+    m_waitStart = LatencyRecorder::now();
+    emit propBatch(batch);
+}
+
+bool GameBoard::acceptActivation(int row, int col, int type)
+{
+    if (m_wait != Wait_Activate) return false;
+    int hit = -1;
+    for (int i = m_replayPos; i < m_batchEnd; ++i) {
+        const EngineEvent &ev = m_replay[size_t(i)];
+        if (!m_batchDone[size_t(i - m_batchBegin)] && ev.row == row && ev.col == col && ev.propType == type) {
+            hit = i;
+            break;
         }
     }
+    if (hit < 0) return false;
+    m_batchDone[size_t(hit - m_batchBegin)] = 1;
 
-    return bombMatches;
-}
-
-
-QVector<PropTypedef> GameBoard::findSuperItemMatches() {
-
-    superItemMatches.clear();
-
-    // 横向查找连续 5 个相同颜色的方块
-    for (int r = 0; r < m_rows; ++r) {
-        for (int c = 0; c < m_columns - 4; ++c) {
-            QString color = m_board[r][c];
-            if (!isColor(color)) continue;
-
-            bool isMatch = true;
-            for (int i = 1; i < 5; ++i) {
-                if (m_board[r][c + i] != color) {
-                    isMatch = false;
-                    break;
-                }
-            }
-            if (isMatch) {
-                // 不在检测阶段直接修改棋盘，记录位置交由 creatProp 处理
-                superItemMatches.append({SuperItemType, QPoint(r, c + 2)}); // 超级道具放置位置是连续五个方块中的第三个方块
-                qDebug() << QString("(%1, %2)超级道具").arg(r).arg(c+2);
-            }
-        }
+    // 快照是按日志顺序累积的，只能落盘已完成的最长前缀
+    while (m_replayPos < m_batchEnd && m_batchDone[size_t(m_replayPos - m_batchBegin)]) {
+        applyEvent(m_replay[size_t(m_replayPos)]);
+        ++m_replayPos;
     }
-
-    // 纵向查找连续 5 个相同颜色的方块
-    for (int c = 0; c < m_columns; ++c) {
-        for (int r = 0; r < m_rows - 4; ++r) {
-            QString color = m_board[r][c];
-            if (!isColor(color)) continue;
-
-            bool isMatch = true;
-            for (int i = 1; i < 5; ++i) {
-                if (m_board[r + i][c] != color) {
-                    isMatch = false;
-                    break;
-                }
-            }
-            if (isMatch) {
-                superItemMatches.append({SuperItemType, QPoint(r + 2, c)}); // 超级道具放置位置是连续五个方块中的第三个方块
-                qDebug() << QString("(%1, %2)超级道具").arg(r+2).arg(c);
-            }
-        }
+    if (m_replayPos == m_batchEnd) {
+        m_latency.record(LatencyRecorder::Phase_PropBatch, m_waitStart, LatencyRecorder::now(),
+                         m_replay[size_t(m_batchBegin)].wave);
+        advanceReplay();
     }
-
-    return superItemMatches;
+    else updatePendingActivations();
+    return true;
 }
 
-
-QVector<QPoint> GameBoard::findMatches(int r1, int c1, int r2, int c2, bool argflag) {
-    QVector<QPoint> matches;
-    QSet<QPoint> matchedSet;
-    // 横向匹配 - 普通三消
-    for (int r = 0; r < m_rows; ++r) {
-        for (int c = 0; c < m_columns - 2; ++c) {
-            QString color = m_board[r][c];
-            if (!isColor(color)) continue;
-
-            int matchLength = 1;
-            while (c + matchLength < m_columns && m_board[r][c + matchLength] == color && isColor(m_board[r][c + matchLength])) {
-                matchLength++;
-            }
-            if (matchLength >= 3) {
-                // 普通三消
-                for (int i = 0; i < matchLength; ++i) {
-                    matchedSet.insert(QPoint(r, c + i));
-                }
-            }
-        }
-    }
-
-    // 纵向匹配 - 普通三消
-    for (int c = 0; c < m_columns; ++c) {
-        for (int r = 0; r < m_rows - 2; ++r) {
-            QString color = m_board[r][c];
-            if (!isColor(color)) continue;
-
-            int matchLength = 1;
-            while (r + matchLength < m_rows && m_board[r + matchLength][c] == color && isColor(m_board[r + matchLength][c])) {
-                matchLength++;
-            }
-            if (matchLength >= 3) {
-                // 普通三消
-                for (int i = 0; i < matchLength; ++i) {
-                    matchedSet.insert(QPoint(r + i, c));
-                }
-            }
-        }
+void GameBoard::activateFromQml(int row, int col, int type, uint8_t color)
+{
+    if (acceptActivation(row, col, type)) return;
+    if (replaying()) {
+        M3_TRACE(Cat_Replay, Level_Warn, "activation type %d at (%d,%d) ignored during replay", type, row, col);
+        return;
     }
 
-    if(argflag == true)
+    // 双击道具：动画已由 QML 播放，首个激活事件直接落盘，其余事件继续回放
+    if (!m_moveStart) m_moveStart = LatencyRecorder::now();
+    m_log.clear();
+    bool activated;
     {
-        // 优先查找五个（超级道具），避免五连同时生成其他道具
-        findSuperItemMatches();
-
-        // 计算：所有被“五连”覆盖到的格子集合（用于彻底屏蔽同一条五连中产生的火箭）
-        QSet<QPoint> superCoveredCells;
-        for (const PropTypedef &sp : superItemMatches) {
-            int cr = sp.point.x();
-            int cc = sp.point.y();
-            if (cr < 0 || cr >= m_rows || cc < 0 || cc >= m_columns) continue;
-            QString color = m_board[cr][cc];
-            if (!isColor(color)) continue;
-            // 横向扩展
-            int left = cc, right = cc;
-            while (left-1 >= 0 && m_board[cr][left-1] == color) left--;
-            while (right+1 < m_columns && m_board[cr][right+1] == color) right++;
-            if (right - left + 1 >= 5) {
-                int start = cc - 2; if (start < left) start = left; if (start > right - 4) start = right - 4;
-                for (int c = start; c < start + 5; ++c) superCoveredCells.insert(QPoint(cr, c));
-            }
-            // 纵向扩展
-            int top = cr, bottom = cr;
-            while (top-1 >= 0 && m_board[top-1][cc] == color) top--;
-            while (bottom+1 < m_rows && m_board[bottom+1][cc] == color) bottom++;
-            if (bottom - top + 1 >= 5) {
-                int start = cr - 2; if (start < top) start = top; if (start > bottom - 4) start = bottom - 4;
-                for (int r = start; r < start + 5; ++r) superCoveredCells.insert(QPoint(r, cc));
-            }
-        }
-
-        // 辅助：检查某点是否已被超级道具占用（仅判断超级道具位置，避免误排除普通三/四消可生成道具的位置）
-        auto isReservedBySuper = [this](const QPoint &pt)->bool{
-            for (const PropTypedef &p : superItemMatches) {
-                if (p.point == pt) return true;
-            }
-            return false;
-        };
-
-        // 查找横向竖向火箭匹配
-        findRocketMatches(r1, c1, r2, c2);
-        if (!rocketMatches.isEmpty()) {
-            QVector<PropTypedef> filtered;
-            for (const PropTypedef &p : rocketMatches) {
-                // 若火箭位置落在五连覆盖的任一格子上，则丢弃，避免与超级道具并存
-                if (superCoveredCells.contains(p.point)) {
-                    qDebug() << "findMatches: skip rocket at (covered by 5-in-a-row)" << p.point;
-                    continue;
-                }
-                // 同时避免与超级道具中心位置冲突
-                if (isReservedBySuper(p.point)) {
-                    qDebug() << "findMatches: skip rocket at" << p.point << "due to superItem priority";
-                    continue;
-                }
-                filtered.append(p);
-            }
-            rocketMatches = filtered;
-        }
-
-        // 查找 T/L 炸弹匹配，同样避免与超级道具冲突
-        findBombMatches();
-        if (!superItemMatches.isEmpty() && !bombMatches.isEmpty()) {
-            QVector<PropTypedef> filtered2;
-            for (const PropTypedef &p : bombMatches) {
-                if (!isReservedBySuper(p.point)) filtered2.append(p);
-                else qDebug() << "findMatches: skip bomb at" << p.point << "due to superItem priority";
-            }
-            bombMatches = filtered2;
-        }
-
-        // NOTE: do NOT emit create signals here. Creation animations should be emitted
-        // when processing matches after the front-end match animation finishes, so that
-        // the swap endpoints (r1,c1,r2,c2) context can be preserved across the animation.
+        LatencyRecorder::Scope timing(&m_latency, LatencyRecorder::Phase_Resolve);
+        activated = m_engine.activateProp(row, col, type, color, m_log);
     }
-    // 返回所有匹配的方块
-    matches.append(matchedSet.values().toVector());
-    return matches;
-}
-
-
-
-QVector<QVector<QPoint>> GameBoard::calculateDropPaths() const {
-    QVector<QVector<QPoint>> dropPaths;
-
-    for (int c = 0; c < m_columns; ++c) {
-        int r = m_rows - 1;
-        while (r >= 0) {
-            // 跳过不可移动(块)位置 或 已被挂起的激活位置（视为阻挡）
-            if (!m_board[r][c].isEmpty() && (!isMovable(m_board[r][c]) || m_pendingActivations.contains(QPoint(r, c)))) {
-                r--;
-                continue;
-            }
-
-            int segmentBottom = r;
-            int segmentTop = r;
-            while (segmentTop >= 0 && (m_board[segmentTop][c].isEmpty() || (isMovable(m_board[segmentTop][c]) && !m_pendingActivations.contains(QPoint(segmentTop, c))))) {
-                // 只要是空或者可移动且不是挂起激活点就继续
-                segmentTop--;
-            }
-            segmentTop++;
-
-            int writeRow = segmentBottom;
-            for (int rr = segmentBottom; rr >= segmentTop; --rr) {
-                // 只有非挂起且可移动的格子会下落
-                if (isMovable(m_board[rr][c]) && !m_pendingActivations.contains(QPoint(rr, c))) {
-                    if (rr != writeRow) {
-                        QVector<QPoint> path;
-                        for (int pp = rr; pp <= writeRow; ++pp) {
-                            path.append(QPoint(pp, c));
-                        }
-                        dropPaths.append(path);
-                    }
-                    writeRow--;
-                }
-            }
-
-            r = segmentTop - 1;
-        }
+    if (!activated) {
+        m_moveStart = 0;
+        M3_TRACE(Cat_Replay, Level_Warn, "activation type %d at (%d,%d) rejected by engine", type, row, col);
+        return;
     }
-    return dropPaths;
-}
-
-// 把上方的格子往下掉
-void GameBoard::applyGravity() {
-    qDebug() << "applyGravity: start";
-    for (int c = 0; c < m_columns; ++c) {
-        int r = m_rows - 1;
-        while (r >= 0) {
-            // 如果遇到不可移动的背景块或挂起激活点，跳过
-            if (!m_board[r][c].isEmpty() && (!isMovable(m_board[r][c]) || m_pendingActivations.contains(QPoint(r, c)))) {
-                r--;
-                continue;
-            }
-
-            int segmentBottom = r;
-            int segmentTop = r;
-            while (segmentTop >= 0 && (m_board[segmentTop][c].isEmpty() || (isMovable(m_board[segmentTop][c]) && !m_pendingActivations.contains(QPoint(segmentTop, c))))) {
-                segmentTop--;
-            }
-            segmentTop++;
-
-            int writeRow = segmentBottom;
-            for (int rr = segmentBottom; rr >= segmentTop; --rr) {
-                // 只有非挂起且可移动的格子会下落
-                if (isMovable(m_board[rr][c]) && !m_pendingActivations.contains(QPoint(rr, c))) {
-                    if (writeRow != rr) {
-                        qDebug() << "applyGravity: move(" << rr << "," << c << ") -> (" << writeRow << "," << c << ") value=" << m_board[rr][c];
-                        // 如果源格有挂起激活（理论上不应出现，但防御性处理），把挂起位置迁移到目标格
-                        QPoint src(rr, c);
-                        QPoint dst(writeRow, c);
-                        bool srcPending = m_pendingActivations.contains(src);
-                        if (srcPending) {
-                            m_pendingActivations.remove(src);
-                            m_pendingActivations.insert(dst);
-                            qDebug() << "applyGravity: moved pending activation" << src << "->" << dst;
-                        }
-
-                        m_board[writeRow][c] = m_board[rr][c];
-                        m_board[rr][c] = "";
-                    } else {
-                        // no-op move, stays in place
-                    }
-                    writeRow--;
-                }
-            }
-
-            // 将剩余位置清空(这些位置是在区段顶部)，但不要覆盖挂起的激活点
-            for (int rr = writeRow; rr >= segmentTop; --rr) {
-                if (m_pendingActivations.contains(QPoint(rr, c))) {
-                    // 如果挂起位置当前为空且没有实际方块，那么这个挂起可能已被移动或失效，移除以避免长期阻塞
-                    if (m_board[rr][c].isEmpty()) {
-                        qDebug() << "applyGravity: removing stale pending activation at" << QPoint(rr,c);
-                        m_pendingActivations.remove(QPoint(rr, c));
-                    }
-                    // 保持挂起点为空，等待激活执行（如果仍有效）
-                    continue;
-                }
-                if (!m_board[rr][c].isEmpty()) {
-                    qDebug() << "applyGravity: clear cell (" << rr << "," << c << ")";
-                }
-                m_board[rr][c] = "";
-            }
-
-            r = segmentTop - 1;
-        }
+    recordHistory();
+    int first = 0;
+    while (first < int(m_log.size()) && m_log[size_t(first)].kind != EngineEvent::Event_Activate) ++first;
+    if (first < int(m_log.size())) {
+        applyEvent(m_log[size_t(first)]);
+        ++first;
     }
-    qDebug() << "applyGravity: end";
+    startReplay(m_log, first);
 }
 
-void GameBoard::removeMatchedTiles(const QVector<QPoint> &matches) {
-    for (const QPoint &pt : matches) {
-        QString v = m_board[pt.x()][pt.y()];
-        // 根据颜色递增统计（0-5）
-        if (v == "red") addStatAt(0);
-        else if (v == "green") addStatAt(1);
-        else if (v == "blue") addStatAt(2);
-        else if (v == "yellow") addStatAt(3);
-        else if (v == "purple") addStatAt(4);
-        else if (v == "brown") addStatAt(5);
-        m_board[pt.x()][pt.y()] = "";
-        m_pendingActivations.remove(pt);
-    }
-    updateScore(matches.size() * 10);
+QVariantList GameBoard::cellsToVariant(const std::vector<int> &cells) const
+{
+    QVariantList list;
+    list.reserve(int(cells.size()));
+    for (int idx : cells) list.append(QVariant::fromValue(QPoint(idx / m_columns, idx % m_columns)));
+    return list;
 }
 
-// 创建道具
-void GameBoard::creatProp()
+QVariantList GameBoard::dropsToVariant(const EngineEvent &ev) const
 {
-    // 创建火箭
-    for (const PropTypedef &pt : rocketMatches) {
-        m_board[pt.point.x()][pt.point.y()] = (pt.type == 1 ? Rocket_UpDown : Rocket_LeftRight);
-        qDebug() << "creatProp: rocket at" << pt.point << "type" << pt.type;
-    }
+    // 每条路径为下落经过的格子序列，起点在上、终点在下；补位的方块从棋盘上方（负行号）落入
+    QVariantList paths;
+    paths.reserve(int(ev.drops.size() + ev.cells.size()));
+    for (const DropMove &d : ev.drops) {
+        QVariantList path;
+        for (int r = d.fromRow; r <= d.toRow; ++r) path.append(QVariant::fromValue(QPoint(r, d.col)));
+        paths.append(QVariant(path));
+    }
+    std::vector<int> spawned(size_t(m_board.columns()), 0);
+    for (int idx : ev.cells) spawned[size_t(idx % m_board.columns())]++;
+    for (int idx : ev.cells) {
+        const int row = idx / m_board.columns(), col = idx % m_board.columns();
+        QVariantList path;
+        for (int r = row - spawned[size_t(col)]; r <= row; ++r) path.append(QVariant::fromValue(QPoint(r, col)));
+        paths.append(QVariant(path));
+    }
+    return paths;
+}
+
+QString GameBoard::tileName(uint8_t tile) const {
+    if (tileIsColor(tile)) return m_availableColors[tile - Tile_Red];
+    switch (tile) {
+    case Tile_RocketUpDown:    return Rocket_UpDown;
+    case Tile_RocketLeftRight: return Rocket_LeftRight;
+    case Tile_Bomb:            return Bomb;
+    case Tile_SuperItem:       return SuperItem;
+    default:                   return QString();
+    }
+}
+
+uint8_t GameBoard::tileCode(const QString &name) const {
+    int idx = m_availableColors.indexOf(name);
+    if (idx >= 0) return uint8_t(Tile_Red + idx);
+    if (name == Rocket_UpDown)    return Tile_RocketUpDown;
+    if (name == Rocket_LeftRight) return Tile_RocketLeftRight;
+    if (name == Bomb)             return Tile_Bomb;
+    if (name == SuperItem)        return Tile_SuperItem;
+    return Tile_Empty;
+}
+
+// ---------------------------------------------------------------------------
+// QML 回调
+// ---------------------------------------------------------------------------
 
-    // 创建炸弹
-    for (const PropTypedef &pt : bombMatches) {
-        m_board[pt.point.x()][pt.point.y()] = Bomb;
-        qDebug() << "creatProp: bomb at" << pt.point;
+Q_INVOKABLE void GameBoard::processMatches()
+{
+    if (m_wait != Wait_Match) {
+        M3_TRACE(Cat_Replay, Level_Debug, "processMatches: no pending match");
+        return;
     }
+    const EngineEvent &ev = m_replay[size_t(m_replayPos)];
 
-    // 创建超级道具
-    for (const PropTypedef &pt : superItemMatches) {
-        m_board[pt.point.x()][pt.point.y()] = SuperItem;
-        qDebug() << "creatProp: superItem at" << pt.point;
+    // 在移除匹配前先通知前端播放道具生成动画（如果有）
+    QVector<PropTypedef> rocketMatches, bombMatches, superItemMatches;
+    for (const PropPlacement &p : ev.props) {
+        const PropTypedef prop = {p.type, QPoint(p.row, p.col)};
+        if (p.type == BombType) bombMatches.append(prop);
+        else if (p.type == SuperItemType) superItemMatches.append(prop);
+        else rocketMatches.append(prop);
     }
-}
+    M3_TRACE(Cat_Replay, Level_Debug, "processMatches: %d cells, %d props", int(ev.cells.size()), int(ev.props.size()));
+    if (!rocketMatches.isEmpty()) emit rocketCreateRequested(rocketMatches);
+    if (!bombMatches.isEmpty()) emit bombCreateRequested(bombMatches);
+    if (!superItemMatches.isEmpty()) emit superItemCreateRequested(superItemMatches);
 
-// 新增帮助函数实现
-bool GameBoard::isColor(const QString &color) const {
-    return m_availableColors.contains(color);
-}
+    m_latency.record(LatencyRecorder::Phase_MatchAnimation, m_waitStart, LatencyRecorder::now());
 
-bool GameBoard::isMovable(const QString &color) const {
-    if (color.isEmpty()) return false;
-    if (color == Rocket_UpDown || color == Rocket_LeftRight || color == Bomb || color == SuperItem) return true;
-    return m_availableColors.contains(color);
+    // 然后移除匹配并实际在棋盘上创建道具，继续回放下落
+    applyEvent(ev);
+    ++m_replayPos;
+    advanceReplay();
 }
 
-void GameBoard::updateScore(int points) {
-    m_score += points;
-    emit scoreChanged(m_score);
-}
-
-void GameBoard::updateStep(int step){
-    static bool isEnd = false;
-    if(step == -1){
-        if(m_step == 1){
-            m_step -= 1;
-            isEnd = true;
-        } else {
-            m_step -= 1;
-        }
-
-    } else {
-        m_step = step;
-    }
-    emit stepChanged(m_step);
-    if(isEnd){
-        isEnd = false;
-        emit gameOver();
-    }
+Q_INVOKABLE void GameBoard::processDrop()
+{
+    // 下落由回放驱动；若前端丢失了下落动画请求则重新发出
+    if (m_wait != Wait_Drop) return;
+    flushBoardDiff();
+    emit dropAnimationRequested(dropsToVariant(m_replay[size_t(m_replayPos)]));
 }
 
 Q_INVOKABLE void GameBoard::commitDrop()
 {
-    qDebug() << "commitDrop: before applyGravity";
-    // 打印当前板状态（用于对比）
-    for (int r = 0; r < m_rows; ++r) {
-        QString rowStr;
-        for (int c = 0; c < m_columns; ++c) {
-            rowStr += (m_board[r][c].isEmpty() ? "__" : m_board[r][c]) + QString(" ");
-        }
-        qDebug() << "commitDrop before: row" << r << ":" << rowStr;
-    }
-
-    applyGravity();
-
-    qDebug() << "commitDrop: after applyGravity";
-    for (int r = 0; r < m_rows; ++r) {
-        QString rowStr;
-        for (int c = 0; c < m_columns; ++c) {
-            rowStr += (m_board[r][c].isEmpty() ? "__" : m_board[r][c]) + QString(" ");
-        }
-        qDebug() << "commitDrop after gravity: row" << r << ":" << rowStr;
-    }
-
-    fillNewTiles();
-
-    qDebug() << "commitDrop: after fillNewTiles";
-    for (int r = 0; r < m_rows; ++r) {
-        QString rowStr;
-        for (int c = 0; c < m_columns; ++c) {
-            rowStr += (m_board[r][c].isEmpty() ? "__" : m_board[r][c]) + QString(" ");
-        }
-        qDebug() << "commitDrop after fill: row" << r << ":" << rowStr;
+    if (m_wait != Wait_Drop) {
+        M3_TRACE(Cat_Replay, Level_Debug, "commitDrop: no pending drop");
+        return;
     }
+    m_latency.record(LatencyRecorder::Phase_DropAnimation, m_waitStart, LatencyRecorder::now());
+    m_model->clearDrops();      // 下落事件已在动画开始前落盘
+    ++m_replayPos;
+    advanceReplay();
+}
 
-    emit boardChanged();
-    // 检查是否还有三消
-    finalizeSwap(0,0,0,0,true);
+void GameBoard::rocketEffectTriggered(int row, int col, int type)
+{
+    activateFromQml(row, col, type, Tile_Empty);
 }
 
-// 新增 helper 实现
-bool GameBoard::isRocket(const QString &color) const {
-    return color == Rocket_UpDown || color == Rocket_LeftRight;
+void GameBoard::bombEffectTriggered(int row, int col)
+{
+    activateFromQml(row, col, BombType, Tile_Empty);
 }
 
-bool GameBoard::isBomb(const QString &color) const {
-    return color == Bomb;
+void GameBoard::superItemEffectTriggered(int row, int col, QString inputColor)
+{
+    activateFromQml(row, col, SuperItemType, tileCode(inputColor));
 }
 
-// 新增：两个火箭组合触发（在 QML 播放合成动画结束后调用）
+// 组合只能由交换产生，回放中没有对应事件的回调（如超级+超级动画的第二次回调）直接忽略
 void GameBoard::rocketRocketTriggered(int row, int col)
 {
-    // 组合开始时立即解除挂起并清空所有 pending，避免后续 finalizeSwap 阻塞
-    m_comboPending = false;
-    m_pendingActivations.clear();
-
-    // 先消耗两个参与点
-    for (const QPoint &p : m_comboParticipants) {
-        if (!m_board[p.x()][p.y()].isEmpty()) {
-            qDebug() << "rocketRocketTriggered: consume combo participant at" << p << "value=" << m_board[p.x()][p.y()];
-        }
-        m_board[p.x()][p.y()] = "";
-        m_pendingActivations.remove(p);
-    }
-
-    QVector<QPoint> clearedNow;
-    // 在 row, col 交叉清除
-    for (int c = 0; c < m_columns; c++) {
-        QPoint pt(row, c);
-        if (pt == QPoint(row, col)) continue; // 跳过参与点
-        QString v = m_board[row][c];
-        if (v.isEmpty()) continue;
-        if (m_comboParticipants.contains(pt)) continue;
-        if (isBomb(v)) {
-            schedulePropEffect(row, c, BombType, QString(), 500);
-        } else if (isRocket(v)) {
-            schedulePropEffect(row, c, (v==Rocket_UpDown?Rocket_UpDownType:Rocket_LeftRightType), QString(), 500);
-        } else if (v == SuperItem) {
-            QString chosen = chooseNearbyColor(row, c);
-            schedulePropEffect(row, c, SuperItemType, chosen, 500);
-        } else {
-            clearedNow.append(QPoint(row, c));
-            m_board[row][c] = "";
-            m_pendingActivations.remove(QPoint(row, c));
-        }
-    }
-    for (int r = 0; r < m_rows; r++) {
-        QPoint pt(r, col);
-        if (pt == QPoint(row, col)) continue; // 跳过参与点
-        QString v = m_board[r][col];
-        if (v.isEmpty()) continue;
-        if (m_comboParticipants.contains(pt)) continue;
-        if (isBomb(v)) {
-            schedulePropEffect(r, col, BombType, QString(), 500);
-        } else if (isRocket(v)) {
-            schedulePropEffect(r, col, (v==Rocket_UpDown?Rocket_UpDownType:Rocket_LeftRightType), QString(), 500);
-        } else if (v == SuperItem) {
-            QString chosen = chooseNearbyColor(r, col);
-            schedulePropEffect(r, col, SuperItemType, chosen, 500);
-        } else {
-            if (r != row) clearedNow.append(QPoint(r, col));
-            m_board[r][col] = "";
-            m_pendingActivations.remove(QPoint(r, col));
-        }
-    }
-    qDebug() << "rocketRocketTriggered: cleared cells:" << clearedNow.size();
-    updateScore(clearedNow.size() * 10);
-    // 组合激活统计
-    addStatAt(9);
-    emit boardChanged();
-    processDrop();
-    clearComboParticipants();
+    acceptActivation(row, col, Combo_RocketRocketType);
 }
 
-// 新增：两个炸弹组合触发（更大半径爆炸）
 void GameBoard::bombBombTriggered(int row, int col)
 {
-    m_comboPending = false;
-    m_pendingActivations.clear();
-
-    // 先消耗两个参与点
-    for (const QPoint &p : m_comboParticipants) {
-        if (!m_board[p.x()][p.y()].isEmpty()) {
-            qDebug() << "bombBombTriggered: consume combo participant at" << p << "value=" << m_board[p.x()][p.y()];
-        }
-        m_board[p.x()][p.y()] = "";
-        m_pendingActivations.remove(p);
-    }
-
-    int radius = 4;
-    QVector<QPoint> expected;
-    QVector<QPoint> clearedNow;
-
-    // 同样先消耗触发炸弹本体，避免重复激活
-    if (row >= 0 && row < m_rows && col >= 0 && col < m_columns) {
-        if (!m_board[row][col].isEmpty()) {
-            qDebug() << "bombBombTriggered: consume activator at" << QPoint(row,col) << "value=" << m_board[row][col];
-        }
-        m_board[row][col] = "";
-        m_pendingActivations.remove(QPoint(row,col));
-    }
-
-    // 先计算期望清除的格子（基于整数平方距离），用于对比调试
-    for (int r = row - radius; r <= row + radius; ++r) {
-        for (int c = col - radius; c <= col + radius; ++c) {
-            if (r >= 0 && r < m_rows && c >= 0 && c < m_columns) {
-                int dr = r - row, dc = c - col;
-                if (dr*dr + dc*dc <= radius*radius) expected.append(QPoint(r,c));
-            }
-        }
-    }
-
-    // 清除圆形范围内的方块（使用整数判断）
-    for (const QPoint &pt : expected) {
-        int r = pt.x();
-        int c = pt.y();
-        // 跳过触发来源自身位置（该炸弹自身已被清空）
-        if (r == row && c == col) continue;
-
-        QString v = m_board[r][c];
-        if (v.isEmpty()) continue;
-
-        // 如果是道具，调度其激活（不立即清空）
-        if (isBomb(v)) {
-            schedulePropEffect(r, c, BombType, QString(), 500);
-        } else if (isRocket(v)) {
-            int rocketType = (v == Rocket_UpDown) ? Rocket_UpDownType : Rocket_LeftRightType;
-            schedulePropEffect(r, c, rocketType, QString(), 500);
-        } else if (v == SuperItem) {
-            QString choose = chooseNearbyColor(r, c);
-            schedulePropEffect(r, c, SuperItemType, choose, 500);
-        } else {
-            m_board[r][c] = "";
-            clearedNow.append(pt);
-        }
-    }
-
-    // 记录未被清除但应被清除的位置（理论上应该为空）
-    QVector<QPoint> missed;
-    for (const QPoint &pt : expected) {
-        if (!m_board[pt.x()][pt.y()].isEmpty()) {
-            missed.append(pt);
-        }
-    }
-
-    qDebug() << "bombBombTriggered: bomb at" << QPoint(row,col) << "expected cells:" << expected.size() << "clearedNow:" << clearedNow.size() << "missed:" << missed;
-    if (!missed.isEmpty()) {
-        qDebug() << "bombBombTriggered: missed positions (should be empty):" << missed;
-    }
-
-    updateScore(clearedNow.size() * 10);
-    // 组合激活统计
-    addStatAt(10);
-    emit boardChanged();
-    processDrop();
-    clearComboParticipants();
+    acceptActivation(row, col, Combo_BombBombType);
 }
 
-// 新增：炸弹与火箭组合触发
 void GameBoard::bombRocketTriggered(int row, int col, int rocketType)
 {
-    m_comboPending = false;
-    m_pendingActivations.clear();
-
-    // 先消耗两个参与点
-    for (const QPoint &p : m_comboParticipants) {
-        if (!m_board[p.x()][p.y()].isEmpty()) {
-            qDebug() << "bombRocketTriggered: consume combo participant at" << p << "value=" << m_board[p.x()][p.y()];
-        }
-        m_board[p.x()][p.y()] = "";
-        m_pendingActivations.remove(p);
-    }
-
-    QVector<QPoint> clearedNow;
-    if (rocketType == Rocket_UpDownType) {
-        for (int dc = -1; dc <= 1; ++dc) {
-            int cc = col + dc;
-            if (cc < 0 || cc >= m_columns) continue;
-            for (int r = 0; r < m_rows; ++r) {
-                QPoint pt(r, cc);
-                if (pt == QPoint(row, col)) continue; // 跳过参与点
-                QString v = m_board[r][cc];
-                if (v.isEmpty()) continue;
-                if (m_comboParticipants.contains(pt)) continue; // 跳过最近组合参与集合
-
-                if (isBomb(v)) {
-                    schedulePropEffect(r, cc, BombType, QString(), 500);
-                } else if (isRocket(v)) {
-                    schedulePropEffect(r, cc, (v==Rocket_UpDown?Rocket_UpDownType:Rocket_LeftRightType), QString(), 500);
-                } else if (v == SuperItem) {
-                    QString chosen = chooseNearbyColor(r, cc);
-                    schedulePropEffect(r, cc, SuperItemType, chosen, 500);
-                } else {
-                    clearedNow.append(QPoint(r, cc));
-                    m_board[r][cc] = "";
-                    m_pendingActivations.remove(QPoint(r, cc));
-                }
-            }
-        }
-        qDebug() << "bombRocketTriggered: rocket(vertical) + bomb at" << QPoint(row,col) << "cleared cols" << col-1 << col << col+1 << "=> total:" << clearedNow.size();
-    } else if (rocketType == Rocket_LeftRightType) {
-        for (int dr = -1; dr <= 1; ++dr) {
-            int rr = row + dr;
-            if (rr < 0 || rr >= m_rows) continue;
-            for (int c = 0; c < m_columns; ++c) {
-                QPoint pt(rr, c);
-                if (pt == QPoint(row, col)) continue; // 跳过参与点
-                QString v = m_board[rr][c];
-                if (v.isEmpty()) continue;
-                if (m_comboParticipants.contains(pt)) continue; // 跳过最近组合参与集合
-
-                if (isBomb(v)) {
-                    schedulePropEffect(rr, c, BombType, QString(), 500);
-                } else if (isRocket(v)) {
-                    schedulePropEffect(rr, c, (v==Rocket_UpDown?Rocket_UpDownType:Rocket_LeftRightType), QString(), 500);
-                } else if (v == SuperItem) {
-                    QString chosen = chooseNearbyColor(rr, c);
-                    schedulePropEffect(rr, c, SuperItemType, chosen, 500);
-                } else {
-                    clearedNow.append(QPoint(rr, c));
-                    m_board[rr][c] = "";
-                    m_pendingActivations.remove(QPoint(rr, c));
-                }
-            }
-        }
-        qDebug() << "bombRocketTriggered: rocket(horizontal) + bomb at" << QPoint(row,col) << "cleared rows" << row-1 << row << row+1 << "=> total:" << clearedNow.size();
-    }
-
-    updateScore(clearedNow.size() * 10);
-    // 组合激活统计
-    addStatAt(11);
-    emit boardChanged();
-    processDrop();
-    clearComboParticipants();
+    Q_UNUSED(rocketType);
+    acceptActivation(row, col, Combo_BombRocketType);
 }
 
-// 新增：超级道具 + 火箭 组合触发
 void GameBoard::superRocketTriggered(int row, int col)
 {
-    // 重要：动画完成进入逻辑阶段，解除组合挂起状态
-    m_comboPending = false;
-    m_pendingActivations.remove(QPoint(row, col));
-    clearComboParticipants();
-
-    qDebug() << "superRocketTriggered: at" << QPoint(row,col);
-    QString chosen = chooseNearbyColor(row, col);
-    if (chosen.isEmpty()) {
-        qDebug() << "superRocketTriggered: no color chosen, abort";
-        return;
-    }
-
-    QVector<QPoint> converted;
-    // 将场上所有该颜色格子替换为随机方向的火箭
-    for (int r = 0; r < m_rows; ++r) {
-        for (int c = 0; c < m_columns; ++c) {
-            if (m_board[r][c] == chosen) {
-                // 随机选择竖向或横向火箭
-                bool vertical = QRandomGenerator::global()->bounded(2) == 0;
-                m_board[r][c] = vertical ? Rocket_UpDown : Rocket_LeftRight;
-                converted.append(QPoint(r,c));
-                m_pendingActivations.remove(QPoint(r,c));
-            }
-        }
-    }
-
-    // 清除超级道具自身位置
-    if (row >= 0 && row < m_rows && col >= 0 && col < m_columns) {
-        m_board[row][col] = "";
-        m_pendingActivations.remove(QPoint(row,col));
-    }
-
-    qDebug() << "superRocketTriggered: chosen color" << chosen << "converted to rockets:" << converted.size();
-    emit boardChanged();
-
-    // 激活所有新火箭（延迟以便前端显示）
-    for (const QPoint &pt : converted) {
-        QString v = m_board[pt.x()][pt.y()];
-        int type = (v == Rocket_UpDown) ? Rocket_UpDownType : Rocket_LeftRightType;
-        schedulePropEffect(pt.x(), pt.y(), type, QString(), 500);
-    }
-
-    // 次数统计
-    addStatAt(12);
-    updateScore(converted.size() * 10);
+    acceptActivation(row, col, Combo_SuperRocketType);
 }
 
-
-// 新增：超级道具 + 炸弹 组合触发
 void GameBoard::superBombTriggered(int row, int col)
 {
-    // 重要：动画完成进入逻辑阶段，解除组合挂起状态
-    m_comboPending = false;
-    m_pendingActivations.remove(QPoint(row, col));
-    clearComboParticipants();
-
-    qDebug() << "superBombTriggered: at" << QPoint(row,col);
-    // 从超级道具位置的四邻中选择一个颜色
-    QString chosen = chooseNearbyColor(row, col);
-    if (chosen.isEmpty()) {
-        qDebug() << "superBombTriggered: no color chosen, abort";
-        return;
-    }
-
-    QVector<QPoint> converted;
-    // 将场上所有该颜色格子替换为炸弹
-    for (int r = 0; r < m_rows; ++r) {
-        for (int c = 0; c < m_columns; ++c) {
-            if (m_board[r][c] == chosen) {
-                m_board[r][c] = Bomb;
-                converted.append(QPoint(r,c));
-                // 如果之前该位置有挂起激活，移除（此处已变为炸弹并会被 schedule）
-                m_pendingActivations.remove(QPoint(r,c));
-            }
-        }
-    }
-
-    // 清除超级道具自身位置（防止残留）
-    if (row >= 0 && row < m_rows && col >= 0 && col < m_columns) {
-        m_board[row][col] = "";
-        m_pendingActivations.remove(QPoint(row,col));
-    }
-
-    qDebug() << "superBombTriggered: chosen color" << chosen << "converted to bombs:" << converted.size();
-    emit boardChanged();
-
-    // 将所有新炸弹激活（延迟以便前端显示）
-    for (const QPoint &pt : converted) {
-        schedulePropEffect(pt.x(), pt.y(), BombType, QString(), 500);
-    }
-
-    // 次数统计
-    addStatAt(13);
-    // 计分
-    updateScore(converted.size() * 10);
+    acceptActivation(row, col, Combo_SuperBombType);
 }
 
-// 新增：超级道具合成触发（占位符，实际逻辑已在其他地方实现）
 Q_INVOKABLE void GameBoard::superSuperTriggered(int row, int col)
 {
-    // 重要：动画完成进入逻辑阶段，解除组合挂起状态
-    m_comboPending = false;
-    // 保障存在于链接单元的最小实现，实际逻辑已在另一处完善
-
-    qDebug() << "superSuperTriggered (stub): at" << QPoint(row, col);
-    QVector<QPoint> clearedNow;
-    for (int r = 0; r < m_rows; ++r) {
-        for (int c = 0; c < m_columns; ++c) {
-            if (!m_board[r][c].isEmpty()) {
-                m_board[r][c].clear();
-                clearedNow.append(QPoint(r,c));
-            }
-        }
-    }
-
-    // 次数统计
-    addStatAt(14);
-    updateScore(clearedNow.size() * 10);
-    emit boardChanged();
-    processDrop();
+    acceptActivation(row, col, Combo_SuperSuperType);
 }
 
-
-Q_INVOKABLE void GameBoard::processDrop()
-{
-    qDebug() << "processDrop: calculating drop paths";
-    QVector<QVector<QPoint>> paths = calculateDropPaths();
-
-    QVariantList variantPaths;
-    for (const QVector<QPoint> &path : paths) {
-        QVariantList singlePath;
-        for (const QPoint &pt : path) {
-            singlePath.append(QVariant::fromValue(pt));
-        }
-        variantPaths.append(singlePath);
-    }
-
-    if (!variantPaths.isEmpty()) {
-        qDebug() << "processDrop: emitting dropAnimationRequested with paths count" << variantPaths.size();
-        emit dropAnimationRequested(variantPaths);
-    } else {
-        qDebug() << "processDrop: no drops, checking if fill needed or matches";
-        // 如果没有下落路径，先检查是否有空格需要补充（例如被道具清空但没有上方方块落下）
-        bool hasEmpty = false;
-        for (int r = 0; r < m_rows && !hasEmpty; ++r) {
-            for (int c = 0; c < m_columns; ++c) {
-                if (m_board[r][c].isEmpty()) { hasEmpty = true; break; }
-            }
-        }
-
-        if (hasEmpty) {
-            qDebug() << "processDrop: found empty cells, calling commitDrop to apply gravity and fill";
-            // 直接调用 commitDrop 执行下落与补位（QML 无下落动画时后端需立即完成数据变更）
-            commitDrop();
-        } else {
-            qDebug() << "processDrop: no drops and no empty cells, checking matches";
-            // 如果没有下落路径且没有空格，则检查是否存在匹配需要处理
-            finalizeSwap(0, 0, 0, 0, true);
-        }
-    }
-}
-
-Q_INVOKABLE void GameBoard::processMatches()
-{
-    qDebug() << "processMatches: scanning for matches";
-    QVector<QPoint> matches = findMatches(0, 0, 0, 0, true);
-    if (!matches.isEmpty()) {
-        qDebug() << "processMatches: found" << matches.size() << "matched tiles, removing and creating props";
-
-        // 如果之前 finalizeSwap 在交换时已计算并保留了道具位置，则优先使用保留的结果
-        if (m_reservedPropsPending) {
-            rocketMatches = m_reservedRocketMatches;
-            bombMatches = m_reservedBombMatches;
-            superItemMatches = m_reservedSuperItemMatches;
-            // 清除保留标记，避免重复
-            m_reservedPropsPending = false;
-            m_reservedRocketMatches.clear();
-            m_reservedBombMatches.clear();
-            m_reservedSuperItemMatches.clear();
-        }
-
-        // 在移除匹配前先通知前端播放道具生成动画（如果有）
-        if (!rocketMatches.isEmpty()) {
-            emit rocketCreateRequested(rocketMatches);
-        }
-        if (!bombMatches.isEmpty()) {
-            emit bombCreateRequested(bombMatches);
-        }
-        if (!superItemMatches.isEmpty()) {
-            emit superItemCreateRequested(superItemMatches);
-        }
-
-        // 然后移除匹配并实际在棋盘上创建道具
-        removeMatchedTiles(matches);
-        creatProp();
-        emit boardChanged();
-        // 处理下落（视觉由 QML 播放，随后 QML 调用 commitDrop）
-        processDrop();
-    } else {
-        qDebug() << "processMatches: no matches";
-    }
-}
-
-// 新增：实现超级道具的普通效果（清除全盘指定颜色）
-void GameBoard::superItemEffectTriggered(int row, int col, QString inputColor)
-{
-    // 重要：动画完成进入逻辑阶段，解除组合挂起状态
-    m_comboPending = false;
-    // 清除延迟激活标记
-    m_pendingActivations.remove(QPoint(row, col));
-
-    qDebug() << "superItemEffectTriggered: at" << QPoint(row, col) << "color:" << inputColor;
-
-    // 消耗激活器自身
-    if (row >= 0 && row < m_rows && col >= 0 && col < m_columns) {
-        m_pendingActivations.remove(QPoint(row, col));
-        if (!m_board[row][col].isEmpty()) {
-            qDebug() << "superItemEffectTriggered: consume activator at" << QPoint(row, col) << "value=" << m_board[row][col];
-        }
-        m_board[row][col] = "";
-    }
-
-    // 选择要清除的颜色
-    QString chosen = inputColor;
-    if (chosen.isEmpty()) {
-        chosen = chooseNearbyColor(row, col);
-    }
-    if (chosen.isEmpty()) {
-        qDebug() << "superItemEffectTriggered: no color chosen, abort";
-        return;
-    }
-
-    int cleared = 0;
-    // 清除全盘该颜色的普通方块（保留道具）
-    for (int r = 0; r < m_rows; ++r) {
-        for (int c = 0; c < m_columns; ++c) {
-            QString v = m_board[r][c];
-            if (v == chosen && isColor(v)) {
-                m_board[r][c] = "";
-                m_pendingActivations.remove(QPoint(r, c));
-                cleared++;
-            }
-        }
-    }
-
-    qDebug() << "superItemEffectTriggered: cleared color" << chosen << "count:" << cleared;
-    updateScore(cleared * 10);
-    // 单体超级激活次数
-    addStatAt(8);
-    emit boardChanged();
-    processDrop();
-}
+// ---------------------------------------------------------------------------
+// 游戏控制
+// ---------------------------------------------------------------------------
 
 // 新增：开始游戏（初始化棋盘并重置分数/连击）
 void GameBoard::startGame()
 {
     initializeBoard();
-    m_board[3][3] = SuperItem;
-    m_board[3][4] = Rocket_LeftRight;
+    m_engine.setTile(3, 3, Tile_SuperItem);
+    m_engine.setTile(3, 4, Tile_RocketLeftRight);
+    m_board = m_engine.board();
+    publishBoard();
+    resetHistory();
 }
 
 // 新增：重置游戏（清空分数并重新生成棋盘）
 void GameBoard::resetGame()
 {
-    qDebug() << "resetGame";
+    M3_TRACE(Cat_Replay, Level_Info, "resetGame");
     m_step = m_init_step;
     m_score = 0;
     m_comboCnt = 0;
-    for(int i = 0; i < 12; ++i)
-    {
+    for (int i = 0; i < StatCount; ++i) {
         m_stats[i] = 0;
     }
+    m_engine.resetCounters(m_step);
     emit scoreChanged(m_score);
     emit stepChanged(m_step);
     emit statsChanged(stats());
@@ -1540,48 +761,17 @@ void GameBoard::resetGame()
 // 新增：打乱棋盘（保持道具与不可移动块不变，仅打乱普通颜色；并确保无初始三消）
 void GameBoard::shuffleBoard()
 {
-    qDebug() << "shuffleBoard";
-    // 收集所有可移动的普通颜色位置
-    QVector<QPoint> colorCells;
-    QVector<QString> colors;
-    for (int r = 0; r < m_rows; ++r) {
-
-        for (int c = 0; c < m_columns; ++c) {
-            QString v = m_board[r][c];
-            if (isColor(v)) {
-                colorCells.append(QPoint(r, c));
-                colors.append(v);
-            }
-        }
-    }
-    if (colors.isEmpty()) {
-        emit boardChanged();
+    if (replaying()) {
+        publishBoard();
         return;
     }
-
-    // 随机打乱颜色列表
-    for (int i = colors.size() - 1; i > 0; --i) {
-        int j = QRandomGenerator::global()->bounded(i + 1);
-        std::swap(colors[i], colors[j]);
-    }
-
-    // 赋回到棋盘
-    for (int i = 0; i < colorCells.size(); ++i) {
-        const QPoint &pt = colorCells[i];
-        m_board[pt.x()][pt.y()] = colors[i];
+    const uint64_t before = m_engine.board().hash();
+    const int repairs = m_engine.shuffle();
+    if (m_engine.board().hash() == before) {
+        M3_TRACE(Cat_Board, Level_Warn, "shuffle left the board unchanged");
     }
-
-    // 如仍有匹配则重新生成直到无匹配（防御性，避免初始消除）
-    int guard = 0;
-    while (!findMatches(0, 0, 0, 0, false).isEmpty() && guard < 50) {
-        // 简单重新随机填充普通颜色
-        for (const QPoint &pt : colorCells) {
-            m_board[pt.x()][pt.y()] = getRandomColor();
-        }
-        guard++;
-    }
-
-    emit boardChanged();
+    m_board = m_engine.board();
+    publishBoard();
+    recordHistory();
+    emit boardReshuffled(repairs);
 }
-
-
@@ -6,32 +6,31 @@
 #include <QString>
 #include <QPoint>
 #include <QVariant>
-#include <QSet>
+#include <QStringList>
+
+#include "CellBitset.h"
+#include "LatencyRecorder.h"
+#include "TileGrid.h"
+#include "MatchFinder.h"
+#include "Match3Engine.h"
+#include "MoveSolver.h"
+#include "UndoHistory.h"
+#include "BoardModel.h"
 
 #define Rocket_UpDown    "Rocket_1"
 #define Rocket_LeftRight "Rocket_2"
 #define Bomb             "Bomb"
 #define SuperItem        "SuperItem"
 
-#define Rocket_UpDownType    1
-#define Rocket_LeftRightType 2
-#define BombType             3
-#define SuperItemType        4
-
-// 新增组合道具类型，用于在 propEffect 中编码复合激活（QML 识别并播放合成动画）
-#define Combo_RocketRocketType 100
-#define Combo_BombBombType     101
-#define Combo_BombRocketType   102
-#define Combo_SuperBombType    103 // 超级道具 + 炸弹
-#define Combo_SuperRocketType  104 // 超级道具 + 火箭
-#define Combo_SuperSuperType   105 // 超级道具 + 超级道具（两次全图涟漪清除）
-
 typedef struct
 {
     int type;
     QPoint point;
 }PropTypedef;
 
+// QML 适配层：游戏逻辑全部由 Match3Engine 同步结算，
+// 本类把结算得到的事件日志按前端动画节奏逐条回放成信号，
+// 并在 QML 回调（processMatches / commitDrop / *Triggered）到来时推进回放
 class GameBoard : public QObject
 {
     Q_OBJECT
@@ -42,27 +41,58 @@ class GameBoard : public QObject
     Q_PROPERTY(int init_step READ init_step WRITE setInitStep NOTIFY init_stepChanged) // 将 init_step 设为可写
     Q_PROPERTY(int comboCount READ comboCount NOTIFY comboChanged)
     Q_PROPERTY(QVariantList stats READ stats NOTIFY statsChanged)
+    Q_PROPERTY(quint64 seed READ seed WRITE setSeed NOTIFY seedChanged) // 写入种子会以该种子重新开局
+    Q_PROPERTY(BoardModel *boardModel READ boardModel CONSTANT)         // 棋盘列表模型，供 Repeater 直接绑定
+    Q_PROPERTY(bool canUndo READ canUndo NOTIFY historyChanged)
+    Q_PROPERTY(bool canRedo READ canRedo NOTIFY historyChanged)
 
 public:
-    explicit GameBoard(QObject *parent = nullptr, int rows = 8, int columns = 8);
+    // backend 选择三消检测后端：逐格扫描、按颜色位棋盘（棋盘最大 64x64）或 SIMD 行/列扫描（大棋盘）
+    // seed 为本局随机种子（棋盘生成、补位、道具随机性），默认取系统熵；相同种子 + 相同操作逐位复现
+    explicit GameBoard(QObject *parent = nullptr, int rows = 8, int columns = 8,
+                       MatchFinder::Backend backend = MatchFinder::Backend_Scalar,
+                       quint64 seed = randomSeed());
+
+    static quint64 randomSeed();
 
     // 游戏控制接口
     Q_INVOKABLE void startGame();
     Q_INVOKABLE void resetGame();
     Q_INVOKABLE void shuffleBoard();
+    // 撤销/重做：恢复棋盘、分数、步数与统计（含补位随机数状态，重做同一步得到同样的补位）。
+    // 回放中不可用；历史有界，最多保留最近 HistoryCapacity - 1 步
+    Q_INVOKABLE bool undo();
+    Q_INVOKABLE bool redo();
 
     // 核心操作
     Q_INVOKABLE QString tileAt(int row, int col) const;
+    // 编码 -> QML 名称表（下标为 TileCode，即 BoardModel 的 tileCode，空串表示空格），QML 缓存一次即可
+    Q_INVOKABLE QStringList tileNames() const;
+    // 引擎棋盘的 64 位 Zobrist 哈希（随每次写格增量维护，O(1)），可作提示缓存、置换表与回放校验的键
+    Q_INVOKABLE quint64 boardHash() const { return m_engine.board().hash(); }
     Q_INVOKABLE void trySwap(int r1, int c1, int r2, int c2);
     Q_INVOKABLE void finalizeSwap(int r1, int c1, int r2, int c2, bool isRecursion);
     Q_INVOKABLE void processMatches();
     Q_INVOKABLE void processDrop();
     Q_INVOKABLE void commitDrop();
 
+    // 提示：当前所有会产生效果的交换，每项为 {r1, c1, r2, c2, cleared, propType}
+    // cleared 为预计直接清除的格子数，propType 为 0（普通三消）或将触发的道具/组合类型
+    Q_INVOKABLE QVariantList availableMoves() const;
+    // 前瞻搜索的最佳交换 {r1, c1, r2, c2, value, depth}，budgetMs 内迭代加深（至少搜完一层）；
+    // 回放中或无步可走时返回空表。value 为期望得分增益
+    Q_INVOKABLE QVariantMap bestMove(int budgetMs = 50);
+    // 自动走一步：按 bestMove 的结果走 trySwap 的正常流程（QML 播完交换动画后照常 finalizeSwap）
+    Q_INVOKABLE bool playBestMove(int budgetMs = 50);
+
     // 道具处理
     Q_INVOKABLE void rocketEffectTriggered(int row, int col, int type);  // 火箭激活信号
     Q_INVOKABLE void bombEffectTriggered(int row, int col);              // 炸弹激活信号
     Q_INVOKABLE void superItemEffectTriggered(int row, int col, QString color);
+    // 圆形爆炸半径（type 为 BombType / Combo_BombBombType），转发到引擎；爆炸动画据此高亮与引擎相同的范围
+    Q_INVOKABLE int blastRadius(int type) const { return m_engine.blastRadius(type); }
+    // 调参：回放中不可修改，类型不是圆形爆炸或半径为负时返回 false
+    Q_INVOKABLE bool setBlastRadius(int type, int radius);
 
     // 新增：组合道具触发（由 QML 在合成动画结束后调用）
     Q_INVOKABLE void rocketRocketTriggered(int row, int col);
@@ -81,21 +111,37 @@ public:
         return list;
     }
 
+    // 延迟统计：每步各阶段（引擎计算与等待 QML 的往返）的耗时分布，常开。
+    // 返回 {阶段名: {count, meanMs, minMs, p50Ms, p90Ms, p99Ms, maxMs}}，只含有样本的阶段
+    Q_INVOKABLE QVariantMap latencyStats() const;
+    Q_INVOKABLE void resetLatencyStats();
+    // 保留最近 maxSpans 段供导出（0 关闭）；saveLatencyTrace 写出 Chrome trace-event JSON
+    Q_INVOKABLE void setLatencyTrace(int maxSpans);
+    Q_INVOKABLE bool saveLatencyTrace(const QString &path) const;
+
     int rows() const { return m_rows; }
     int columns() const { return m_columns; }
     int score() const { return m_score; }
     int step() const { return m_step;}
     int init_step() const { return m_init_step;}
     int comboCount() const { return m_comboCnt; }
+    quint64 seed() const { return m_engine.seed(); }
+    bool canUndo() const { return !replaying() && m_history.canUndo(); }
+    bool canRedo() const { return !replaying() && m_history.canRedo(); }
+    BoardModel *boardModel() const { return m_model; }
 
     void setInitStep(int v) { m_init_step = v; emit init_stepChanged(m_init_step); }
+    void setSeed(quint64 seed);
 
 signals:
+    // 整盘刷新（开局、重置、打乱）
     void boardChanged();
     void scoreChanged(int newScore);
     void stepChanged(int step);
     void init_stepChanged(int init_step);
     void comboChanged(int comboCount);  // 发送连击数
+    void seedChanged(quint64 seed);
+    void historyChanged();
     // 新增：统计变化通知
     void statsChanged(const QVariantList &stats);
 
@@ -107,41 +153,57 @@ signals:
     void invalidSwap(int r1, int c1, int r2, int c2);
     void rollbackSwap(int r1, int c1, int r2, int c2);
     void gameOver();
+    // 棋盘被重排（手动打乱或结算后无步可走时自动重排），参数为局部修复次数
+    void boardReshuffled(int repairIterations);
 
     // 道具添加请求前端动画信号
     void rocketCreateRequested(const QVector<PropTypedef> &rocketMatches);
     void bombCreateRequested(const QVector<PropTypedef> &bombMatches);
     void superItemCreateRequested(const QVector<PropTypedef> &superItemMatches);
 
-    // 交换后道具激活信号
-    void propEffect(int row, int col, int type, QString color);
+    // 道具激活批次：一次连锁中所有激活按层级（wave）排好序一次性发出，
+    // 每项为 {row, col, type, color, wave, delayMs}，delayMs 为相对批次开始的建议启动时间，
+    // 同层可并行播放；每个激活动画播完后照旧调用对应的 *Triggered
+    void propBatch(const QVariantList &activations);
 
 private:
+    // 回放当前停在哪类事件上，等待 QML 的哪个回调
+    enum ReplayWait {
+        Wait_None,
+        Wait_Match,     // 已发 matchAnimationRequested，等 processMatches
+        Wait_Drop,      // 已发 dropAnimationRequested，等 commitDrop
+        Wait_Activate   // 已发 propBatch，等批次内各激活的 *Triggered
+    };
+
     int m_init_step = 25;
     int m_comboCnt;
     int m_rows;
     int m_columns;
     int m_score;
     int m_step;
-    bool m_comboPending; // 防止组合触发期间重复处理
-    QVector<QVector<QString>> m_board;
-    QVector<QString> m_availableColors;
-    QVector<PropTypedef> rocketMatches;   // 用于记录火箭匹配
-    QVector<PropTypedef> bombMatches;     // 用于记录炸弹匹配
-    QVector<PropTypedef> superItemMatches; // 用于记录超级道具匹配
-    QSet<QPoint> m_pendingActivations; // 记录已调度但尚未执行的道具激活位置
-
-    // 新增：记录最近一次组合参与的两个位置，避免组合后再次单体激活
-    QSet<QPoint> m_comboParticipants;
-
-    // 延迟激活动作：用于在 4 连/5 连先生成新道具后，再激活旧道具
-    struct DeferredActivation {
-        int row = -1;
-        int col = -1;
-        int type = 0;
-        QString color;
-        bool valid = false;
-    } m_deferredActivation;
+    Match3Engine m_engine;             // 无 Qt 依赖的结算核心，持有权威棋盘
+    LatencyRecorder m_latency;         // 引擎各阶段与回放往返的耗时
+    uint64_t m_swapRequested = 0;      // 发出 swapAnimationRequested 的时刻（0 为没有）
+    uint64_t m_moveStart = 0;          // 本步被接受的时刻，回放结束时计入 Phase_Settle
+    uint64_t m_waitStart = 0;          // 当前等待（m_wait）开始的时刻
+    MoveSolver m_solver;               // 提示与自动走步的前瞻搜索，在引擎副本上试走
+    UndoHistory m_history;             // 每步结算后的引擎快照
+    TileGrid m_board;                  // 展示给 QML 的棋盘：随回放推进，回放结束后与引擎一致
+    BoardModel *m_model;               // 与 m_publishedBoard 同步
+    TileGrid m_publishedBoard;         // 最近一次下发到 m_model 的棋盘
+    CellBitset m_touched;              // 被前端动画改动过外观的格子，即使编码未变也要随下次 diff 下发
+    std::vector<int> m_changed;        // flushBoardDiff 的暂存，跨次复用
+    std::vector<int> m_pendingCells;   // updatePendingActivations 的暂存，跨次复用
+    bool m_diffQueued = false;
+    QVector<QString> m_availableColors; // 颜色名称表，下标 = 编码 - Tile_Red，仅用于 QML 边界的字符串映射
+
+    EventLog m_replay;                 // 正在回放的事件日志
+    EventLog m_log;                    // 引擎输出用的日志，与 m_replay 交换后复用上一轮的事件缓冲
+    int m_replayPos = 0;
+    int m_batchEnd = 0;                // 当前激活批次为 [m_replayPos, m_batchEnd)
+    std::vector<uint8_t> m_batchDone;  // 批次内各激活的动画是否已播完（下标相对批次起点 m_batchBegin）
+    int m_batchBegin = 0;
+    ReplayWait m_wait = Wait_None;
 
     // 新增：统计数组
     // 0-5= 颜色
@@ -156,51 +218,45 @@ private:
     // 14 = 超级触发+超级触发
     int m_stats[15] = {0};
 
-    // 新增：保留由一次交换产生的道具集合，避免随后自动检测再重复发射创建信号
-    bool m_reservedPropsPending = false;
-    QVector<PropTypedef> m_reservedRocketMatches;
-    QVector<PropTypedef> m_reservedBombMatches;
-    QVector<PropTypedef> m_reservedSuperItemMatches;
-
     void initializeBoard();
-    void fillNewTiles();
-    bool isProp(QString color);
-    bool isValidSwap(int r1, int c1, int r2, int c2); // 移除const
-    QVector<QPoint> findMatches(int r1, int c1, int r2, int c2, bool argflag);
-    QVector<QVector<QPoint>> calculateDropPaths() const;
-    void removeMatchedTiles(const QVector<QPoint> &matches);
-    void creatProp();
-    void applyGravity();
-    QString getRandomColor() const;
-    void updateScore(int points);
-    void updateStep(int step);
-
-    QVector<PropTypedef> findBombMatches();
-    QVector<PropTypedef> findRocketMatches(int r1, int c1, int r2, int c2);
-    QVector<PropTypedef> findSuperItemMatches();
-    void clearRow(int row);    // 清除行
-    void clearColumn(int col); // 清除列
-
-    // 新增帮助函数
-    bool isColor(const QString &color) const;    // 判断是否为常规颜色格子
-    bool isMovable(const QString &color) const;  // 判断该格子是否应当参与下落（颜色或道具）
-    bool isRocket(const QString &color) const;  // 判断是否为火箭道具
-    bool isBomb(const QString &color) const;    // 判断是否为炸弹道具
-
-    // 调度/连锁相关辅助
-    void schedulePropEffect(int row, int col, int type, const QString &color, int delayMs);
-    QString chooseNearbyColor(int row, int col) const;
-
-    // 新增：道具激活后检查并处理新三消
-    void checkAndProcessNewMatches();
-
-    // 新增：组合参与点的标记清理
-    inline void markComboParticipants(int r1, int c1, int r2, int c2) {
-        m_comboParticipants.insert(QPoint(r1, c1));
-        m_comboParticipants.insert(QPoint(r2, c2));
-    }
-    inline void clearComboParticipants() { m_comboParticipants.clear(); }
-
+    // 历史：以当前局面为起点 / 记录一步之后的局面 / 撤销重做之后把展示状态同步到引擎
+    void resetHistory();
+    void recordHistory();
+    void restoreFromEngine();
+    // 分数、步数、连击与统计同步到 counters，有变化的发出对应信号
+    void syncCounters(const EngineCounters &counters);
+
+    // 棋盘刷新：publishBoard 整盘下发；markBoardDirty 记下改动并排队到本轮事件循环末尾，
+    // 在发出下一个动画请求前或事件循环空闲时由 flushBoardDiff 合并下发
+    void publishBoard();
+    void markBoardDirty(const EngineEvent *ev = nullptr);
+    void flushBoardDiff();
+    // 把回放中尚未激活的道具格子同步到模型
+    void updatePendingActivations();
+
+    // 回放
+    bool replaying() const { return m_replayPos < int(m_replay.size()); }
+    // 本步画面已与引擎一致：记录从接受交换到此刻的总耗时
+    void finishMove();
+    // 以 budgetMs 为预算搜索当前局面
+    SolverResult searchBestMove(int budgetMs);
+    void startReplay(EventLog &log, int firstPos);
+    void abortReplay();
+    void advanceReplay();
+    void applyEvent(const EngineEvent &ev);
+    // 从当前位置起连续的激活事件组成一个批次，一次性发给 QML
+    void emitActivationBatch();
+    // QML 播完某个激活动画：若属于当前批次则标记完成，并把已完成的前缀依次落盘，返回是否匹配
+    bool acceptActivation(int row, int col, int type);
+    // 回放之外的单体激活（双击道具）：交给引擎结算后回放其余事件
+    void activateFromQml(int row, int col, int type, uint8_t color);
+
+    QVariantList cellsToVariant(const std::vector<int> &cells) const;
+    QVariantList dropsToVariant(const EngineEvent &ev) const;
+
+    // 编码与 QML 字符串之间的映射（仅在 tileAt/propBatch 等边界使用）
+    QString tileName(uint8_t tile) const;
+    uint8_t tileCode(const QString &name) const;
 };
 
 #endif // GAMEBOARD_H
@@ -0,0 +1,67 @@
+﻿#ifndef GAMERNG_H
+#define GAMERNG_H
+
+#include <cstdint>
+
+// 每个棋盘独立持有的随机数发生器（xoshiro128**，16 字节状态）
+// 只使用定宽整数运算且不经过 std::uniform_int_distribution，
+// 同一种子在任何平台/编译器上都产生完全相同的序列：种子 + 操作序列即可逐位复现整局
+class GameRng
+{
+public:
+    explicit GameRng(uint64_t seed = 0) { reseed(seed); }
+
+    // 用 splitmix64 把 64 位种子展开为完整状态（任意种子都不会得到全零状态）
+    void reseed(uint64_t seed) {
+        m_seed = seed;
+        uint64_t x = seed;
+        for (int i = 0; i < 4; i += 2) {
+            const uint64_t z = splitmix64(x);
+            m_state[i] = uint32_t(z);
+            m_state[i + 1] = uint32_t(z >> 32);
+        }
+    }
+
+    uint64_t seed() const { return m_seed; }
+
+    uint32_t next() {
+        const uint32_t result = rotl(m_state[1] * 5, 7) * 9;
+        const uint32_t t = m_state[1] << 9;
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = rotl(m_state[3], 11);
+        return result;
+    }
+
+    // [0, n) 内均匀分布（Lemire 乘法取高位 + 拒绝采样，无偏且几乎不做除法），n 须 > 0
+    int bounded(int n) {
+        const uint32_t range = uint32_t(n);
+        uint64_t m = uint64_t(next()) * range;
+        uint32_t low = uint32_t(m);
+        if (low < range) {
+            const uint32_t threshold = uint32_t(-range) % range;
+            while (low < threshold) {
+                m = uint64_t(next()) * range;
+                low = uint32_t(m);
+            }
+        }
+        return int(m >> 32);
+    }
+
+private:
+    static uint32_t rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+    static uint64_t splitmix64(uint64_t &x) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t m_seed = 0;
+    uint32_t m_state[4];
+};
+
+#endif // GAMERNG_H
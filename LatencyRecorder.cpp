@@ -0,0 +1,140 @@
+﻿#include "LatencyRecorder.h"
+#include "RunScanner.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+const char *const PhaseNames[] = {
+    "resolve", "detect", "props", "wave", "gravity", "shuffle",
+    "swapAnimation", "matchAnimation", "propBatch", "dropAnimation", "settle"
+};
+
+bool isEnginePhase(int phase)
+{
+    return phase <= LatencyRecorder::Phase_Shuffle;
+}
+}
+
+LatencyRecorder::LatencyRecorder()
+{
+    reset();
+}
+
+const char *LatencyRecorder::phaseName(Phase phase)
+{
+    return phase >= 0 && phase < PhaseCount ? PhaseNames[phase] : "?";
+}
+
+int LatencyRecorder::bucketOf(uint64_t nanos)
+{
+    if (nanos < uint64_t(SubCount)) return int(nanos);
+    const int msb = RunScanner::highestBit(nanos);
+    if (msb > MaxBit) return BucketCount - 1;
+    // 最高位以下的 SubBits 位决定区间内的子桶
+    return (msb - SubBits + 1) * SubCount + int((nanos >> (msb - SubBits)) & uint64_t(SubCount - 1));
+}
+
+uint64_t LatencyRecorder::bucketMid(int bucket)
+{
+    if (bucket < SubCount) return uint64_t(bucket);
+    const int shift = bucket / SubCount - 1;
+    const uint64_t low = uint64_t(SubCount + bucket % SubCount) << shift;
+    return low + (uint64_t(1) << shift) / 2;
+}
+
+void LatencyRecorder::record(Phase phase, uint64_t start, uint64_t end, int arg)
+{
+    const uint64_t nanos = end > start ? end - start : 0;
+    PhaseStats &s = m_phases[phase];
+    if (s.count == 0 || nanos < s.min) s.min = nanos;
+    if (nanos > s.max) s.max = nanos;
+    s.count++;
+    s.sum += nanos;
+    s.buckets[bucketOf(nanos)]++;
+
+    if (!m_spans.empty()) {
+        Span &span = m_spans[size_t(m_spanCount % m_spans.size())];
+        span.start = start;
+        span.duration = nanos;
+        span.arg = arg;
+        span.phase = uint8_t(phase);
+        m_spanCount++;
+    }
+}
+
+void LatencyRecorder::reset()
+{
+    std::memset(m_phases, 0, sizeof(m_phases));
+    m_spanCount = 0;
+}
+
+uint64_t LatencyRecorder::percentile(Phase phase, double q) const
+{
+    const PhaseStats &s = m_phases[phase];
+    if (s.count == 0) return 0;
+    if (q <= 0.0) return s.min;
+    if (q >= 1.0) return s.max;
+    // 第 rank 个样本（1 起）所在的桶
+    uint64_t rank = uint64_t(q * double(s.count) + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < BucketCount; ++b) {
+        seen += s.buckets[b];
+        if (seen < rank) continue;
+        const uint64_t mid = bucketMid(b);
+        return mid < s.min ? s.min : (mid > s.max ? s.max : mid);
+    }
+    return s.max;
+}
+
+LatencyRecorder::Summary LatencyRecorder::summary(Phase phase) const
+{
+    const PhaseStats &s = m_phases[phase];
+    Summary out;
+    out.count = s.count;
+    if (s.count == 0) return out;
+    out.mean = double(s.sum) / double(s.count);
+    out.min = s.min;
+    out.max = s.max;
+    out.p50 = percentile(phase, 0.50);
+    out.p90 = percentile(phase, 0.90);
+    out.p99 = percentile(phase, 0.99);
+    return out;
+}
+
+void LatencyRecorder::setTraceCapacity(int maxSpans)
+{
+    m_spans.assign(size_t(maxSpans > 0 ? maxSpans : 0), Span());
+    m_spanCount = 0;
+}
+
+std::string LatencyRecorder::chromeTrace() const
+{
+    const size_t capacity = m_spans.size();
+    const size_t kept = capacity == 0 ? 0 : size_t(m_spanCount < capacity ? m_spanCount : capacity);
+    const size_t first = size_t(m_spanCount - kept);
+
+    uint64_t origin = 0;
+    for (size_t i = 0; i < kept; ++i) {
+        const Span &span = m_spans[(first + i) % capacity];
+        if (i == 0 || span.start < origin) origin = span.start;
+    }
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                       "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"engine\"}},\n"
+                       "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"replay\"}}";
+    char line[192];
+    for (size_t i = 0; i < kept; ++i) {
+        const Span &span = m_spans[(first + i) % capacity];
+        const bool engine = isEnginePhase(span.phase);
+        std::snprintf(line, sizeof(line),
+                      ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                      "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"arg\":%d}}",
+                      PhaseNames[span.phase], engine ? "engine" : "replay", engine ? 1 : 2,
+                      double(span.start - origin) / 1000.0, double(span.duration) / 1000.0, span.arg);
+        json += line;
+    }
+    json += "\n]}\n";
+    return json;
+}
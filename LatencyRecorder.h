@@ -0,0 +1,120 @@
+﻿#ifndef LATENCYRECORDER_H
+#define LATENCYRECORDER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 每步各阶段的耗时：引擎内的同步计算（检测、道具、每层激活、下落补位）与 GameBoard 回放中
+// 等待 QML 动画/定时器的往返共用一个记录器。一次记录只是两次时钟读取加定长直方图计数，不分配，
+// 可常开；另可保留最近若干段，导出为 Chrome trace-event JSON（chrome://tracing 或 Perfetto 打开）
+class LatencyRecorder
+{
+public:
+    enum Phase
+    {
+        // 引擎计算
+        Phase_Resolve,          // 交换/双击被接受 -> 引擎结算到稳定（整步计算）
+        Phase_Detect,           // 三消检测：增量扫描 + 取匹配格
+        Phase_Props,            // 道具位置：四连/五连/T/L
+        Phase_Wave,             // 一层激活的执行（arg 为层号）
+        Phase_Gravity,          // 下落与补位：单列内核一次完成，二者不再可分
+        Phase_Shuffle,          // 结算后无步可走的自动重排
+        // 回放（含 QML 动画与定时器）
+        Phase_SwapAnimation,    // swapAnimationRequested -> finalizeSwap
+        Phase_MatchAnimation,   // matchAnimationRequested -> processMatches
+        Phase_PropBatch,        // propBatch -> 批次内最后一个 *Triggered（arg 为首层层号）
+        Phase_DropAnimation,    // dropAnimationRequested -> commitDrop
+        Phase_Settle,           // 交换被接受 -> 回放结束、画面与引擎一致
+        PhaseCount
+    };
+
+    // 某阶段的分布概要，单位纳秒；百分位取所在桶的中点（相对误差不超过 1/32）
+    struct Summary
+    {
+        uint64_t count = 0;
+        double mean = 0.0;
+        uint64_t min = 0;
+        uint64_t max = 0;
+        uint64_t p50 = 0;
+        uint64_t p90 = 0;
+        uint64_t p99 = 0;
+    };
+
+    // 作用域计时：recorder 为空时不读时钟
+    class Scope
+    {
+    public:
+        Scope(LatencyRecorder *recorder, Phase phase, int arg = 0)
+            : m_recorder(recorder), m_phase(phase), m_arg(arg), m_start(recorder ? now() : 0) {}
+        ~Scope() { if (m_recorder) m_recorder->record(m_phase, m_start, now(), m_arg); }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        LatencyRecorder *m_recorder;
+        Phase m_phase;
+        int m_arg;
+        uint64_t m_start;
+    };
+
+    LatencyRecorder();
+
+    // 单调时钟，纳秒
+    static uint64_t now()
+    {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+    static const char *phaseName(Phase phase);
+
+    // 记录一段 [start, end)；开启追踪时同时写入环形缓冲（满时覆盖最旧的一段）
+    void record(Phase phase, uint64_t start, uint64_t end, int arg = 0);
+    // 清空直方图与追踪缓冲
+    void reset();
+
+    uint64_t count(Phase phase) const { return m_phases[phase].count; }
+    Summary summary(Phase phase) const;
+    // q ∈ [0, 1]；没有样本时返回 0
+    uint64_t percentile(Phase phase, double q) const;
+
+    // 保留最近 maxSpans 段用于导出，0 关闭；缓冲只在这里分配一次
+    void setTraceCapacity(int maxSpans);
+    int traceCapacity() const { return int(m_spans.size()); }
+    // Chrome trace-event JSON：引擎计算与回放分两条轨道，时间相对最早保留的一段
+    std::string chromeTrace() const;
+
+private:
+    // 对数-线性直方图：每个 2 的幂区间再等分 16 个桶，覆盖 1 ns 到约 2^40 ns（18 分钟），超出的并入最后一桶
+    static const int SubBits = 4;
+    static const int SubCount = 1 << SubBits;
+    static const int MaxBit = 40;
+    static const int BucketCount = (MaxBit - SubBits + 2) * SubCount;
+
+    struct PhaseStats
+    {
+        uint64_t count;
+        uint64_t sum;
+        uint64_t min;
+        uint64_t max;
+        uint32_t buckets[BucketCount];
+    };
+
+    struct Span
+    {
+        uint64_t start;
+        uint64_t duration;
+        int arg;
+        uint8_t phase;
+    };
+
+    static int bucketOf(uint64_t nanos);
+    static uint64_t bucketMid(int bucket);
+
+    PhaseStats m_phases[PhaseCount];
+    std::vector<Span> m_spans;          // 追踪环，容量即 traceCapacity()
+    uint64_t m_spanCount = 0;           // 累计写入段数，m_spanCount % 容量为下一个写入位置
+};
+
+#endif // LATENCYRECORDER_H
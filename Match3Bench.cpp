@@ -0,0 +1,374 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "GameRng.h"
+#include "Match3Engine.h"
+#include "RunScanner.h"
+
+// 热路径微基准：三消检测（各后端）、道具位置、T/L 炸弹、重力内核、打乱和一次带种子的完整结算，
+// 覆盖 8x8 到 128x128 的棋盘。每项报告 ns/op 与 allocs/op，可输出与 Google Benchmark 相同结构的 JSON，
+// 便于在版本之间比对检测与重力内核的回归
+namespace {
+struct BenchConfig
+{
+    std::vector<int> sizes = {8, 16, 32, 64, 128};
+    double minTime = 0.2;       // 每项至少运行的秒数
+    uint64_t seed = 1;
+    std::string filter;         // 只运行名称包含该子串的项
+    std::string jsonPath;       // 非空时写出 JSON；"-" 为标准输出
+};
+
+struct BenchResult
+{
+    std::string name;
+    long long iterations = 0;
+    double nsPerOp = 0.0;
+    double allocsPerOp = 0.0;
+};
+
+const long long MaxIterations = 1000000000LL;
+
+// 防止被测结果被优化掉
+volatile long long g_sink = 0;
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// 迭代次数按上一轮耗时放大（至少 2 倍、至多 10 倍），直到单轮耗时达到 minTime
+long long nextIterations(long long iterations, double elapsed, double minTime)
+{
+    double factor = elapsed > 0.0 ? 1.4 * minTime / elapsed : 10.0;
+    factor = std::max(2.0, std::min(10.0, factor));
+    return std::min(MaxIterations, std::max(iterations + 1, (long long)(double(iterations) * factor)));
+}
+
+// 整批计时：op 可直接重复执行，不需要每次准备
+template <typename Op>
+BenchResult runBatch(const std::string &name, double minTime, Op &&op)
+{
+    BenchResult result;
+    result.name = name;
+    for (long long iterations = 1;;) {
+        const uint64_t allocsBefore = AllocCounter::count();
+        const Clock::time_point start = Clock::now();
+        for (long long i = 0; i < iterations; ++i) op();
+        const double elapsed = secondsSince(start);
+        result.iterations = iterations;
+        result.nsPerOp = elapsed * 1e9 / double(iterations);
+        result.allocsPerOp = double(AllocCounter::count() - allocsBefore) / double(iterations);
+        if (elapsed >= minTime || iterations >= MaxIterations) break;
+        iterations = nextIterations(iterations, elapsed, minTime);
+    }
+    return result;
+}
+
+// 逐次计时：每次先 setup 把状态复位，setup 的耗时与分配不计入
+template <typename Setup, typename Op>
+BenchResult runWithSetup(const std::string &name, double minTime, Setup &&setup, Op &&op)
+{
+    BenchResult result;
+    result.name = name;
+    for (long long iterations = 1;;) {
+        double elapsed = 0.0;
+        uint64_t allocs = 0;
+        for (long long i = 0; i < iterations; ++i) {
+            setup();
+            const uint64_t allocsBefore = AllocCounter::count();
+            const Clock::time_point start = Clock::now();
+            op();
+            elapsed += secondsSince(start);
+            allocs += AllocCounter::count() - allocsBefore;
+        }
+        result.iterations = iterations;
+        result.nsPerOp = elapsed * 1e9 / double(iterations);
+        result.allocsPerOp = double(allocs) / double(iterations);
+        if (elapsed >= minTime || iterations >= MaxIterations) break;
+        iterations = nextIterations(iterations, elapsed, minTime);
+    }
+    return result;
+}
+
+// 固定种子的随机颜色棋盘（不避开三连，检测器有足够的连续段可找）
+TileGrid randomBoard(int size, uint64_t seed)
+{
+    TileGrid board(size, size);
+    GameRng rng(seed);
+    for (int r = 0; r < size; ++r) {
+        for (int c = 0; c < size; ++c) board.set(r, c, uint8_t(Tile_Red + rng.bounded(TileColorCount)));
+    }
+    return board;
+}
+
+const char *backendName(MatchFinder::Backend backend)
+{
+    switch (backend) {
+    case MatchFinder::Backend_Bitboard: return "bitboard";
+    case MatchFinder::Backend_Simd:     return "simd";
+    default:                            return "scalar";
+    }
+}
+
+std::string benchName(const char *kernel, const char *variant, int size)
+{
+    std::string name = kernel;
+    if (variant) {
+        name += '/';
+        name += variant;
+    }
+    name += '/' + std::to_string(size) + 'x' + std::to_string(size);
+    return name;
+}
+
+class BenchRunner
+{
+public:
+    // table 为逐项打印表格的输出流
+    BenchRunner(const BenchConfig &config, FILE *table) : m_config(config), m_table(table) {}
+
+    void printHeader() const {
+        std::fprintf(m_table, "simd isa: %s, seed %llu, min time %.2f s\n", RunScanner::isaName(RunScanner::activeIsa()),
+                     static_cast<unsigned long long>(m_config.seed), m_config.minTime);
+        std::fprintf(m_table, "%-36s %14s %14s %12s\n", "Benchmark", "Time(ns/op)", "Iterations", "allocs/op");
+    }
+
+    bool wants(const std::string &name) const {
+        return m_config.filter.empty() || name.find(m_config.filter) != std::string::npos;
+    }
+    void add(const BenchResult &result) {
+        std::fprintf(m_table, "%-36s %14.1f %14lld %12.2f\n", result.name.c_str(), result.nsPerOp, result.iterations,
+                     result.allocsPerOp);
+        std::fflush(m_table);
+        m_results.push_back(result);
+    }
+    const std::vector<BenchResult> &results() const { return m_results; }
+
+    void runSize(int size);
+
+private:
+    const BenchConfig &m_config;
+    FILE *m_table;
+    std::vector<BenchResult> m_results;
+};
+
+void BenchRunner::runSize(int size)
+{
+    const double minTime = m_config.minTime;
+    const uint64_t seed = m_config.seed ^ (uint64_t(size) * 0x9E3779B97F4A7C15ULL);
+    const TileGrid board = randomBoard(size, seed);
+    const MatchFinder::Backend backends[] = {
+        MatchFinder::Backend_Scalar, MatchFinder::Backend_Bitboard, MatchFinder::Backend_Simd
+    };
+
+    // 三消检测：全盘扫描 + 取匹配格（findMatches）
+    for (MatchFinder::Backend backend : backends) {
+        const std::string name = benchName("MatchScan", backendName(backend), size);
+        if (!wants(name)) continue;
+        MatchFinder finder(backend);
+        finder.scan(board);
+        add(runBatch(name, minTime, [&]() {
+            finder.scan(board);
+            g_sink += finder.matchedCells().size();
+        }));
+    }
+
+    // 四连/五连道具位置（findRocketMatches）：连续段表不变，只重复推导
+    {
+        const std::string name = benchName("Props", nullptr, size);
+        if (wants(name)) {
+            MatchFinder finder;
+            finder.scan(board);
+            finder.matchedCells();
+            std::vector<PropPlacement> rockets, supers;
+            add(runBatch(name, minTime, [&]() {
+                finder.findProps(0, 0, 0, 0, rockets, supers);
+                g_sink += rockets.size() + supers.size();
+            }));
+        }
+    }
+
+    // T/L 炸弹中心（findBombMatches）
+    for (MatchFinder::Backend backend : backends) {
+        const std::string name = benchName("BombCenters", backendName(backend), size);
+        if (!wants(name)) continue;
+        MatchFinder finder(backend);
+        finder.scan(board);
+        std::vector<int> centers;
+        add(runBatch(name, minTime, [&]() {
+            finder.findBombCenters(board, centers);
+            g_sink += centers.size();
+        }));
+    }
+
+    Match3Engine base(size, size, MatchFinder::Backend_Scalar, seed);
+    base.newBoard();
+    base.resetCounters(1 << 30);
+    // 先让检测器与棋盘同步一次：拷贝出的引擎从而带着已预留的连续段表，计时部分只剩增量检测
+    base.hasMatches();
+
+    // 重力内核：每次先按固定图样挖掉约四分之一的格子，再下落补位（calculateDropPaths / applyGravity / fillNewTiles）
+    {
+        const std::string name = benchName("Gravity", nullptr, size);
+        if (wants(name)) {
+            Match3Engine engine = base;
+            std::vector<DropMove> drops;
+            std::vector<int> spawned;
+            add(runWithSetup(name, minTime, [&]() {
+                for (int r = 0; r < size; ++r) {
+                    for (int c = (r * 3) % 4; c < size; c += 4) engine.setTile(r, c, Tile_Empty);
+                }
+            }, [&]() {
+                engine.dropAndRefill(drops, spawned);
+                g_sink += drops.size() + spawned.size();
+            }));
+        }
+    }
+
+    // 打乱（shuffleBoard）：打乱 + 局部修复 + 保证可走步
+    {
+        const std::string name = benchName("Shuffle", nullptr, size);
+        if (wants(name)) {
+            Match3Engine engine = base;
+            add(runBatch(name, minTime, [&]() { g_sink += engine.shuffle(); }));
+        }
+    }
+
+    // 完整结算：同一带种子的局面上执行同一步交换直到稳定
+    {
+        const std::string name = benchName("Cascade", nullptr, size);
+        const std::vector<MoveHint> &moves = base.availableMoves();
+        if (wants(name) && !moves.empty()) {
+            const MoveHint move = moves[moves.size() / 2];
+            Match3Engine engine = base;
+            EventLog log;
+            log.reserve(64, base.board());
+            add(runWithSetup(name, minTime, [&]() {
+                engine = base;
+                log.clear();
+            }, [&]() {
+                engine.playSwap(move.r1, move.c1, move.r2, move.c2, log);
+                g_sink += log.size();
+            }));
+        }
+    }
+}
+
+bool writeJson(const BenchConfig &config, const std::vector<BenchResult> &results)
+{
+    FILE *out = config.jsonPath == "-" ? stdout : std::fopen(config.jsonPath.c_str(), "w");
+    if (!out) {
+        std::fprintf(stderr, "cannot write %s\n", config.jsonPath.c_str());
+        return false;
+    }
+    std::fprintf(out, "{\n  \"context\": {\n");
+    std::fprintf(out, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+    std::fprintf(out, "    \"simd_isa\": \"%s\",\n", RunScanner::isaName(RunScanner::activeIsa()));
+    std::fprintf(out, "    \"seed\": %llu,\n", static_cast<unsigned long long>(config.seed));
+    std::fprintf(out, "    \"min_time\": %.3f,\n", config.minTime);
+#ifdef NDEBUG
+    std::fprintf(out, "    \"library_build_type\": \"release\"\n");
+#else
+    std::fprintf(out, "    \"library_build_type\": \"debug\"\n");
+#endif
+    std::fprintf(out, "  },\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &r = results[i];
+        std::fprintf(out, "    {\n");
+        std::fprintf(out, "      \"name\": \"%s\",\n", r.name.c_str());
+        std::fprintf(out, "      \"run_type\": \"iteration\",\n");
+        std::fprintf(out, "      \"iterations\": %lld,\n", r.iterations);
+        std::fprintf(out, "      \"real_time\": %.3f,\n", r.nsPerOp);
+        std::fprintf(out, "      \"cpu_time\": %.3f,\n", r.nsPerOp);
+        std::fprintf(out, "      \"time_unit\": \"ns\",\n");
+        std::fprintf(out, "      \"allocs_per_op\": %.4f\n", r.allocsPerOp);
+        std::fprintf(out, "    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+    if (out != stdout) std::fclose(out);
+    return true;
+}
+
+void printUsage(const char *argv0)
+{
+    std::printf("usage: %s [options]\n"
+                "  --sizes LIST    comma-separated board sizes (default 8,16,32,64,128)\n"
+                "  --min-time S    minimum seconds per benchmark (default 0.2)\n"
+                "  --seed S        base seed (default 1)\n"
+                "  --filter TEXT   run only benchmarks whose name contains TEXT\n"
+                "  --json PATH     also write results as JSON, - for stdout\n", argv0);
+}
+
+bool parseSizes(const char *value, std::vector<int> &sizes)
+{
+    sizes.clear();
+    for (const char *p = value; *p;) {
+        char *end = nullptr;
+        const long v = std::strtol(p, &end, 10);
+        if (end == p || v < 3) return false;
+        sizes.push_back(int(v));
+        p = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',') return false;
+    }
+    return !sizes.empty();
+}
+
+bool parseArgs(int argc, char *argv[], BenchConfig &config)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0) return false;
+        if (!value) {
+            std::fprintf(stderr, "missing value for %s\n", arg);
+            return false;
+        }
+        ++i;
+        if (std::strcmp(arg, "--sizes") == 0) {
+            if (!parseSizes(value, config.sizes)) {
+                std::fprintf(stderr, "invalid sizes: %s (each at least 3)\n", value);
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--min-time") == 0) config.minTime = std::atof(value);
+        else if (std::strcmp(arg, "--seed") == 0) config.seed = std::strtoull(value, nullptr, 0);
+        else if (std::strcmp(arg, "--filter") == 0) config.filter = value;
+        else if (std::strcmp(arg, "--json") == 0) config.jsonPath = value;
+        else {
+            std::fprintf(stderr, "unknown option: %s\n", arg);
+            return false;
+        }
+    }
+    if (config.minTime <= 0.0) {
+        std::fprintf(stderr, "min-time must be positive\n");
+        return false;
+    }
+    return true;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    BenchConfig config;
+    if (!parseArgs(argc, argv, config)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // JSON 写到标准输出时表格改走标准错误，避免混在一起
+    BenchRunner runner(config, config.jsonPath == "-" ? stderr : stdout);
+    runner.printHeader();
+    for (int size : config.sizes) runner.runSize(size);
+
+    if (!config.jsonPath.empty() && !writeJson(config, runner.results())) return 1;
+    return 0;
+}
@@ -0,0 +1,31 @@
+# 热路径微基准：三消检测、重力内核、打乱与完整结算，输出 ns/op、allocs/op 与 JSON
+TEMPLATE = app
+TARGET = Match3Bench
+CONFIG += console c++17 release
+CONFIG -= app_bundle qt
+
+SOURCES += \
+        AllocCounter.cpp \
+        ColorBitboard.cpp \
+        LatencyRecorder.cpp \
+        Match3Bench.cpp \
+        Match3Engine.cpp \
+        MatchFinder.cpp \
+        MoveFinder.cpp \
+        PropEffects.cpp \
+        RunScanner.cpp \
+        Trace.cpp
+
+HEADERS += \
+    AllocCounter.h \
+    CellBitset.h \
+    ColorBitboard.h \
+    GameRng.h \
+    LatencyRecorder.h \
+    Match3Engine.h \
+    MatchFinder.h \
+    MoveFinder.h \
+    PropEffects.h \
+    RunScanner.h \
+    TileGrid.h \
+    Trace.h
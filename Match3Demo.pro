@@ -3,8 +3,22 @@ QT += core gui qml quick quickcontrols2 multimedia
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# 调试构建编入热路径追踪（Trace.h 的 M3_TRACE 宏），发布构建中完全移除
+CONFIG(debug, debug|release): DEFINES += MATCH3_TRACE
+
 SOURCES += \
+        BoardModel.cpp \
+        ColorBitboard.cpp \
         GameBoard.cpp \
+        LatencyRecorder.cpp \
+        Match3Engine.cpp \
+        MatchFinder.cpp \
+        MoveFinder.cpp \
+        MoveSolver.cpp \
+        PropEffects.cpp \
+        RunScanner.cpp \
+        Trace.cpp \
+        UndoHistory.cpp \
         main.cpp
 
 RESOURCES += qml.qrc
@@ -26,5 +40,19 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
 
 HEADERS += \
-    GameBoard.h
+    BoardModel.h \
+    CellBitset.h \
+    ColorBitboard.h \
+    GameBoard.h \
+    GameRng.h \
+    LatencyRecorder.h \
+    Match3Engine.h \
+    MatchFinder.h \
+    MoveFinder.h \
+    MoveSolver.h \
+    PropEffects.h \
+    RunScanner.h \
+    TileGrid.h \
+    Trace.h \
+    UndoHistory.h
 
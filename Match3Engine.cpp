@@ -0,0 +1,768 @@
+﻿#include "Match3Engine.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace {
+// 连锁轮数上限，防止极端棋盘（如单色）无限结算
+const int MaxCascadeRounds = 1000;
+// 局部修复次数上限（按格子数放大）；超出时放弃修复，保证生成/打乱耗时有界
+const int RepairIterationsPerCell = 4;
+}
+
+// ---------------------------------------------------------------------------
+// 事件日志
+// ---------------------------------------------------------------------------
+
+void EngineEvent::reset(Kind k)
+{
+    kind = k;
+    row = col = row2 = col2 = 0;
+    propType = 0;
+    color = Tile_Empty;
+    meta = 0;
+    wave = 0;
+    cells.clear();
+    props.clear();
+    drops.clear();
+    counters = EngineCounters();
+}
+
+void EventLog::reserve(size_t events, const TileGrid &board)
+{
+    if (m_events.size() < events) m_events.resize(events);
+    const size_t cells = size_t(board.size());
+    for (EngineEvent &ev : m_events) {
+        ev.cells.reserve(cells);
+        ev.props.reserve(cells);
+        ev.drops.reserve(cells);
+        ev.board = board;
+    }
+}
+
+EngineEvent &EventLog::append(EngineEvent::Kind kind)
+{
+    if (m_size == m_events.size()) m_events.emplace_back();
+    EngineEvent &ev = m_events[m_size++];
+    ev.reset(kind);
+    return ev;
+}
+
+Match3Engine::Match3Engine(int rows, int columns, MatchFinder::Backend backend, uint64_t seed)
+    : m_rows(rows), m_columns(columns), m_board(rows, columns), m_matchFinder(backend),
+      m_effects(defaultPropEffects()), m_rng(seed)
+{
+    // 结算用的暂存都以格子为单位，按棋盘大小一次预留后整局不再增长；圆形效果的跨度也在此建好
+    const size_t cells = size_t(m_board.size());
+    m_matchCells.reserve(cells);
+    m_rocketScratch.reserve(cells);
+    m_superScratch.reserve(cells);
+    m_bombScratch.reserve(cells);
+    m_createdProps.reserve(cells);
+    m_wave.reserve(cells);
+    m_nextWave.reserve(cells);
+    m_shuffleCells.reserve(cells);
+    m_shuffleColors.reserve(cells);
+    m_pinned.reserve(4);
+    m_pendingActivations.resize(m_board.size());
+    m_masks.reset(rows, columns);
+    for (const PropEffect &e : m_effects) prepareMasks(e);
+}
+
+// ---------------------------------------------------------------------------
+// 棋盘与计数
+// ---------------------------------------------------------------------------
+
+int Match3Engine::newBoard()
+{
+    m_board.resize(m_rows, m_columns);
+    m_wave.clear();
+    m_nextWave.clear();
+    m_pendingActivations.resize(m_board.size());
+
+    // 行优先逐格填充：右侧和下方仍为空，只需避开左侧/上方两格，每格至少有 4 种颜色可选
+    for (int r = 0; r < m_rows; ++r) {
+        for (int c = 0; c < m_columns; ++c) {
+            uint8_t color;
+            if (!pickSafeColor(r, c, color)) color = randomColor();
+            m_board.set(r, c, color);
+        }
+    }
+    m_lastRepairIterations = ensureMove();
+    M3_TRACE(Cat_Board, Level_Info, "new board %dx%d, %d repairs", m_rows, m_columns, m_lastRepairIterations);
+    M3_TRACE_BOARD(Cat_Board, "new board", m_board);
+    return m_lastRepairIterations;
+}
+
+int Match3Engine::shuffle()
+{
+    // 收集所有普通颜色位置，道具保持不动
+    std::vector<int> &colorCells = m_shuffleCells;
+    std::vector<uint8_t> &colors = m_shuffleColors;
+    colorCells.clear();
+    colors.clear();
+    for (int i = 0; i < m_board.size(); ++i) {
+        const uint8_t v = m_board.data()[i];
+        if (tileIsColor(v)) {
+            colorCells.push_back(i);
+            colors.push_back(v);
+        }
+    }
+    m_lastRepairIterations = 0;
+    if (colors.empty()) return 0;
+
+    for (int i = int(colors.size()) - 1; i > 0; --i) {
+        std::swap(colors[size_t(i)], colors[size_t(randomBounded(i + 1))]);
+    }
+    for (size_t i = 0; i < colorCells.size(); ++i) {
+        m_board.set(colorCells[i] / m_columns, colorCells[i] % m_columns, colors[i]);
+    }
+
+    // 打乱后仍成三连的格子逐个重染，不再整盘重来
+    m_lastRepairIterations = repairMatches(std::vector<int>());
+    m_lastRepairIterations += ensureMove();
+    M3_TRACE(Cat_Board, Level_Info, "shuffle, %d repairs", m_lastRepairIterations);
+    M3_TRACE_BOARD(Cat_Board, "after shuffle", m_board);
+    return m_lastRepairIterations;
+}
+
+bool Match3Engine::formsRun(int row, int col, uint8_t color) const
+{
+    int left = 0, right = 0, up = 0, down = 0;
+    while (left < 2 && col - left - 1 >= 0 && m_board.at(row, col - left - 1) == color) left++;
+    while (right < 2 && col + right + 1 < m_columns && m_board.at(row, col + right + 1) == color) right++;
+    if (left + right >= 2) return true;
+    while (up < 2 && row - up - 1 >= 0 && m_board.at(row - up - 1, col) == color) up++;
+    while (down < 2 && row + down + 1 < m_rows && m_board.at(row + down + 1, col) == color) down++;
+    return up + down >= 2;
+}
+
+bool Match3Engine::pickSafeColor(int row, int col, uint8_t &color)
+{
+    uint8_t candidates[TileColorCount];
+    int count = 0;
+    for (int k = 0; k < TileColorCount; ++k) {
+        const uint8_t v = uint8_t(Tile_Red + k);
+        if (!formsRun(row, col, v)) candidates[count++] = v;
+    }
+    if (count == 0) return false;
+    color = candidates[randomBounded(count)];
+    return true;
+}
+
+// 逐个重染仍在三连中的格子（跳过 pinned 与道具），每次只改一格，由增量检测器给出剩余三连
+int Match3Engine::repairMatches(const std::vector<int> &pinned)
+{
+    const int limit = RepairIterationsPerCell * m_board.size();
+    int iterations = 0;
+    while (iterations < limit && hasMatches()) {
+        int target = -1;
+        for (int idx : m_matchFinder.matchedCells()) {
+            if (!tileIsColor(m_board.data()[idx])) continue;
+            if (std::find(pinned.begin(), pinned.end(), idx) != pinned.end()) continue;
+            target = idx;
+            // 随机挑一格，避免总是修同一端
+            if (randomBounded(2) == 0) break;
+        }
+        if (target < 0) break;
+        const int r = target / m_columns, c = target % m_columns;
+        uint8_t color;
+        if (!pickSafeColor(r, c, color)) {
+            // 四邻把六种颜色都占满时先随便换一色，下一轮再修被牵连的格子
+            color = uint8_t(Tile_Red + (m_board.at(r, c) - Tile_Red + 1 + randomBounded(TileColorCount - 1)) % TileColorCount);
+        }
+        m_board.set(r, c, color);
+        iterations++;
+    }
+    return iterations;
+}
+
+// 已无可走步时埋入一个“两连 + 斜角一格”的可走步，再修复埋入引起的三连
+int Match3Engine::ensureMove()
+{
+    int iterations = 0;
+    const int limit = RepairIterationsPerCell * m_board.size();
+    while (iterations < limit && !hasAvailableMoves()) {
+        iterations++;
+        if (!plantMove(m_pinned)) break;
+        iterations += repairMatches(m_pinned);
+    }
+    return iterations;
+}
+
+// 在随机位置埋入 XX?/??X 形（或其转置）：交换右下角与其上方格即得到三连
+bool Match3Engine::plantMove(std::vector<int> &pinned)
+{
+    pinned.clear();
+    if (m_rows < 2 || m_columns < 2 || (m_rows < 3 && m_columns < 3)) return false;
+    for (int attempt = 0; attempt < 4 * m_board.size(); ++attempt) {
+        const bool horizontal = m_columns >= 3 && (m_rows < 3 || randomBounded(2) == 0);
+        const int spanR = horizontal ? 2 : 3;
+        const int spanC = horizontal ? 3 : 2;
+        const int r = randomBounded(m_rows - spanR + 1);
+        const int c = randomBounded(m_columns - spanC + 1);
+        // 三个目标格与被交换的格子
+        const int cells[3][2] = {
+            { r, c },
+            { horizontal ? r : r + 1, horizontal ? c + 1 : c },
+            { horizontal ? r + 1 : r + 2, horizontal ? c + 2 : c + 1 }
+        };
+        const int gapR = horizontal ? r : r + 2;
+        const int gapC = horizontal ? c + 2 : c;
+        bool ok = tileIsColor(m_board.at(gapR, gapC));
+        for (const auto &cell : cells) ok = ok && tileIsColor(m_board.at(cell[0], cell[1]));
+        if (!ok) continue;
+
+        uint8_t color = randomColor();
+        if (color == m_board.at(gapR, gapC)) color = uint8_t(Tile_Red + (color - Tile_Red + 1) % TileColorCount);
+        for (const auto &cell : cells) {
+            m_board.set(cell[0], cell[1], color);
+            pinned.push_back(m_board.index(cell[0], cell[1]));
+        }
+        pinned.push_back(m_board.index(gapR, gapC));
+        return true;
+    }
+    return false;
+}
+
+namespace {
+// 快照头部；棋盘编码紧随其后。计数与随机数发生器都是平凡可复制的，按字节整体保存
+struct SnapshotHeader
+{
+    int32_t rows;
+    int32_t columns;
+    uint64_t hash;
+    EngineCounters counters;
+    GameRng rng;
+};
+static_assert(std::is_trivially_copyable<SnapshotHeader>::value, "snapshot header must be trivially copyable");
+}
+
+size_t Match3Engine::snapshotSize() const
+{
+    return sizeof(SnapshotHeader) + size_t(m_board.size());
+}
+
+void Match3Engine::saveSnapshot(uint8_t *out) const
+{
+    SnapshotHeader header;
+    header.rows = m_rows;
+    header.columns = m_columns;
+    header.hash = m_board.hash();
+    header.counters = m_counters;
+    header.rng = m_rng;
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(out + sizeof(header), m_board.data(), size_t(m_board.size()));
+}
+
+bool Match3Engine::restoreSnapshot(const uint8_t *in)
+{
+    SnapshotHeader header;
+    std::memcpy(&header, in, sizeof(header));
+    if (header.rows != m_rows || header.columns != m_columns) return false;
+    m_counters = header.counters;
+    m_rng = header.rng;
+    m_board.assign(in + sizeof(header), header.hash);
+    m_wave.clear();
+    m_nextWave.clear();
+    m_pendingActivations.clear();
+    return true;
+}
+
+void Match3Engine::resetCounters(int steps)
+{
+    m_counters = EngineCounters();
+    m_counters.steps = steps;
+}
+
+bool Match3Engine::hasMatches()
+{
+    m_matchFinder.update(m_board);
+    return m_matchFinder.hasMatches();
+}
+
+void Match3Engine::spendStep()
+{
+    if (m_counters.steps == 1) m_counters.gameOver = true;
+    m_counters.steps -= 1;
+}
+
+EngineEvent &Match3Engine::beginEvent(EventLog &log, EngineEvent::Kind kind)
+{
+    EngineEvent &ev = log.append(kind);
+    // 新槽位：单个事件涉及的格子/道具/下落都不会超过棋盘格子数
+    if (ev.cells.capacity() == 0) {
+        ev.cells.reserve(size_t(m_board.size()));
+        ev.props.reserve(size_t(m_board.size()));
+        ev.drops.reserve(size_t(m_board.size()));
+    }
+    return ev;
+}
+
+void Match3Engine::commitEvent(EventLog &log)
+{
+    EngineEvent &ev = log.back();
+    ev.counters = m_counters;
+    ev.board = m_board;
+    m_counters.gameOver = false;
+}
+
+void Match3Engine::commitSwapEvent(EventLog &log, EngineEvent::Kind kind, int r1, int c1, int r2, int c2)
+{
+    EngineEvent &ev = beginEvent(log, kind);
+    ev.row = r1; ev.col = c1;
+    ev.row2 = r2; ev.col2 = c2;
+    commitEvent(log);
+}
+
+bool Match3Engine::setBlastRadius(int type, int radius)
+{
+    if (radius < 0) return false;
+    for (PropEffect &e : m_effects) {
+        if (e.type != type || e.shape != Shape_Disk) continue;
+        e.param = radius;
+        prepareMasks(e);
+        m_moveFinder.setBlastRadii(blastRadius(BombType), blastRadius(Combo_BombBombType));
+        return true;
+    }
+    return false;
+}
+
+int Match3Engine::blastRadius(int type) const
+{
+    const PropEffect *e = findPropEffect(m_effects, type);
+    return e && e->shape == Shape_Disk ? e->param : -1;
+}
+
+uint8_t Match3Engine::chooseNearbyColor(int row, int col)
+{
+    // 优先从上下左右四个格子随机选一个常规颜色
+    uint8_t candidates[4];
+    int candidateCount = 0;
+    static const int neigh[4][2] = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
+    for (const auto &d : neigh) {
+        const int r = row + d[0];
+        const int c = col + d[1];
+        if (!m_board.contains(r, c)) continue;
+        const uint8_t v = m_board.at(r, c);
+        if (tileIsColor(v)) candidates[candidateCount++] = v;
+    }
+    if (candidateCount > 0) return candidates[randomBounded(candidateCount)];
+
+    // 回退策略：全盘按格子数加权随机选一种颜色
+    int colorCells[TileColorCount] = {0};
+    int total = 0;
+    for (int i = 0; i < m_board.size(); ++i) {
+        const uint8_t v = m_board.data()[i];
+        if (tileIsColor(v)) { colorCells[v - Tile_Red]++; total++; }
+    }
+    if (total > 0) {
+        int pick = randomBounded(total);
+        for (int k = 0; k < TileColorCount; ++k) {
+            if (pick < colorCells[k]) return uint8_t(Tile_Red + k);
+            pick -= colorCells[k];
+        }
+    }
+    return Tile_Empty;
+}
+
+// ---------------------------------------------------------------------------
+// 行动
+// ---------------------------------------------------------------------------
+
+bool Match3Engine::isValidSwap(int r1, int c1, int r2, int c2) const
+{
+    if (!m_board.contains(r1, c1) || !m_board.contains(r2, c2)) return false;
+    // 必须相邻
+    const int dr = r1 > r2 ? r1 - r2 : r2 - r1;
+    const int dc = c1 > c2 ? c1 - c2 : c2 - c1;
+    if (dr + dc != 1) return false;
+    // 不能与空格或背景格子交换
+    return tileIsMovable(m_board.at(r1, c1)) && tileIsMovable(m_board.at(r2, c2));
+}
+
+const std::vector<MoveHint> &Match3Engine::availableMoves() const
+{
+    m_moveFinder.update(m_board);
+    return m_moveFinder.moves(m_board);
+}
+
+bool Match3Engine::hasAvailableMoves() const
+{
+    m_moveFinder.update(m_board);
+    return m_moveFinder.hasMoves();
+}
+
+bool Match3Engine::playSwap(int r1, int c1, int r2, int c2, EventLog &log)
+{
+    if (!isValidSwap(r1, c1, r2, c2)) return false;
+
+    const uint8_t preA = m_board.at(r1, c1);
+    const uint8_t preB = m_board.at(r2, c2);
+    M3_TRACE(Cat_Swap, Level_Info, "swap (%d,%d) <-> (%d,%d)", r1, c1, r2, c2);
+    m_board.swap(r1, c1, r2, c2);
+
+    const bool aIsProp = tileIsProp(preA);
+    const bool bIsProp = tileIsProp(preB);
+
+    // 1) 双道具组合：只触发组合效果，组合落在 (r2, c2)
+    if (aIsProp && bIsProp) {
+        spendStep();
+        commitSwapEvent(log, EngineEvent::Event_Swap, r1, c1, r2, c2);
+        const int partner = m_board.index(r1, c1);
+        const bool aSuper = preA == Tile_SuperItem, bSuper = preB == Tile_SuperItem;
+        const bool aBomb = preA == Tile_Bomb, bBomb = preB == Tile_Bomb;
+        if (aSuper && bSuper) {
+            schedule(r2, c2, Combo_SuperSuperType, Tile_Empty, 0, 0, partner);
+        } else if ((aSuper && bBomb) || (bSuper && aBomb)) {
+            schedule(r2, c2, Combo_SuperBombType, Tile_Empty, 0, 0, partner);
+        } else if (aSuper || bSuper) {
+            schedule(r2, c2, Combo_SuperRocketType, Tile_Empty, 0, 0, partner);
+        } else if (aBomb && bBomb) {
+            schedule(r2, c2, Combo_BombBombType, Tile_Empty, 0, 0, partner);
+        } else if (aBomb || bBomb) {
+            // 炸弹+火箭：记录火箭类型
+            const int rocketType = rocketTypeOf(aBomb ? preB : preA);
+            schedule(r2, c2, Combo_BombRocketType, Tile_Empty, rocketType, 0, partner);
+        } else {
+            schedule(r2, c2, Combo_RocketRocketType, Tile_Empty, 0, 0, partner);
+        }
+        resolve(log, false, r1, c1, r2, c2);
+        return true;
+    }
+
+    // 2) 道具 + 普通颜色：道具在交换后的位置以对方颜色触发单体效果
+    if (aIsProp || bIsProp) {
+        spendStep();
+        commitSwapEvent(log, EngineEvent::Event_Swap, r1, c1, r2, c2);
+        const uint8_t prop = aIsProp ? preA : preB;
+        const uint8_t other = aIsProp ? preB : preA;
+        const int row = aIsProp ? r2 : r1;
+        const int col = aIsProp ? c2 : c1;
+        int type = SuperItemType;
+        if (prop == Tile_RocketUpDown) type = Rocket_UpDownType;
+        else if (prop == Tile_RocketLeftRight) type = Rocket_LeftRightType;
+        else if (prop == Tile_Bomb) type = BombType;
+        schedule(row, col, type, other, 0, 0);
+        resolve(log, false, r1, c1, r2, c2);
+        return true;
+    }
+
+    // 3) 普通匹配：有效行动扣步；否则 4) 回滚且不扣步
+    collectMatches(r1, c1, r2, c2, false);
+    if (m_matchCells.empty()) {
+        commitSwapEvent(log, EngineEvent::Event_Swap, r1, c1, r2, c2);
+        m_board.swap(r1, c1, r2, c2);
+        m_counters.combo = 0;
+        M3_TRACE(Cat_Swap, Level_Debug, "no match, rollback (%d,%d) <-> (%d,%d)", r1, c1, r2, c2);
+        commitSwapEvent(log, EngineEvent::Event_Rollback, r1, c1, r2, c2);
+        return true;
+    }
+
+    spendStep();
+    commitSwapEvent(log, EngineEvent::Event_Swap, r1, c1, r2, c2);
+    resolve(log, true, r1, c1, r2, c2);
+    return true;
+}
+
+bool Match3Engine::activateProp(int row, int col, int type, uint8_t color, EventLog &log)
+{
+    if (!m_board.contains(row, col)) return false;
+    const uint8_t v = m_board.at(row, col);
+    const bool ok = (type == Rocket_UpDownType && v == Tile_RocketUpDown)
+                    || (type == Rocket_LeftRightType && v == Tile_RocketLeftRight)
+                    || (type == BombType && v == Tile_Bomb)
+                    || (type == SuperItemType && v == Tile_SuperItem);
+    if (!ok) return false;
+
+    schedule(row, col, type, color, 0, 0);
+    resolve(log, false, 0, 0, 0, 0);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// 结算循环：激活 -> 下落补位 -> 三消，直到棋盘稳定
+// ---------------------------------------------------------------------------
+
+void Match3Engine::resolve(EventLog &log, bool matchPending, int r1, int c1, int r2, int c2)
+{
+    // 交换产生的第一次三消使用交换端点决定道具位置，之后的连锁统一使用 (0,0)
+    if (matchPending) resolveMatches(log, r1, c1, r2, c2);
+
+    for (int round = 0; round < MaxCascadeRounds; ++round) {
+        if (!m_nextWave.empty()) resolveActivations(log);
+        settle(log);
+        if (!resolveMatches(log, 0, 0, 0, 0)) break;
+    }
+    m_counters.combo = 0;
+
+    // 棋盘稳定后已无可走步：自动重排，保证下一步可玩
+    if (!hasAvailableMoves()) {
+        LatencyRecorder::Scope timing(m_latency, LatencyRecorder::Phase_Shuffle);
+        EngineEvent &ev = beginEvent(log, EngineEvent::Event_Shuffle);
+        ev.meta = shuffle();
+        M3_TRACE(Cat_Board, Level_Warn, "dead board after move, reshuffled with %d repairs", ev.meta);
+        commitEvent(log);
+    }
+}
+
+bool Match3Engine::resolveMatches(EventLog &log, int r1, int c1, int r2, int c2)
+{
+    collectMatches(r1, c1, r2, c2, true);
+    if (m_matchCells.empty()) return false;
+
+    m_counters.combo++;
+    EngineEvent &ev = beginEvent(log, EngineEvent::Event_Match);
+    ev.cells = m_matchCells;
+    ev.props = m_createdProps;
+
+    // 移除匹配（按颜色统计），再在棋盘上创建道具
+    for (int idx : m_matchCells) {
+        const int r = idx / m_columns, c = idx % m_columns;
+        const uint8_t v = m_board.at(r, c);
+        if (tileIsColor(v)) m_counters.stats[Stat_ColorFirst + v - Tile_Red]++;
+        m_board.set(r, c, Tile_Empty);
+    }
+    addScore(int(m_matchCells.size()));
+    M3_TRACE(Cat_Match, Level_Debug, "match %d cells, %d props, combo %d",
+             int(m_matchCells.size()), int(m_createdProps.size()), m_counters.combo);
+    for (const PropPlacement &p : m_createdProps) {
+        uint8_t code = Tile_SuperItem;
+        if (p.type == Rocket_UpDownType) code = Tile_RocketUpDown;
+        else if (p.type == Rocket_LeftRightType) code = Tile_RocketLeftRight;
+        else if (p.type == BombType) code = Tile_Bomb;
+        m_board.set(p.row, p.col, code);
+    }
+    commitEvent(log);
+    return true;
+}
+
+void Match3Engine::collectMatches(int r1, int c1, int r2, int c2, bool withProps)
+{
+    {
+        LatencyRecorder::Scope timing(m_latency, LatencyRecorder::Phase_Detect);
+        m_matchFinder.update(m_board);
+        m_matchCells = m_matchFinder.matchedCells();
+    }
+    m_createdProps.clear();
+    if (!withProps || m_matchCells.empty()) return;
+
+    LatencyRecorder::Scope timing(m_latency, LatencyRecorder::Phase_Props);
+    // 超级道具优先：落在五连覆盖范围内的火箭、与超级道具中心重合的炸弹都让位
+    m_matchFinder.findProps(r1, c1, r2, c2, m_rocketScratch, m_superScratch);
+    m_matchFinder.findBombCenters(m_board, m_bombScratch);
+
+    // 创建顺序与原先一致：火箭、炸弹、超级道具（后写入者覆盖同格）
+    m_createdProps.insert(m_createdProps.end(), m_rocketScratch.begin(), m_rocketScratch.end());
+    for (int idx : m_bombScratch) {
+        const int r = idx / m_columns, c = idx % m_columns;
+        if (!m_matchFinder.isSuperCenter(r, c)) m_createdProps.push_back({BombType, r, c});
+    }
+    m_createdProps.insert(m_createdProps.end(), m_superScratch.begin(), m_superScratch.end());
+}
+
+bool Match3Engine::settle(EventLog &log)
+{
+    bool hasEmpty = false;
+    for (int i = 0; i < m_board.size() && !hasEmpty; ++i) hasEmpty = m_board.data()[i] == Tile_Empty;
+    if (!hasEmpty) return false;
+
+    LatencyRecorder::Scope timing(m_latency, LatencyRecorder::Phase_Gravity);
+    EngineEvent &ev = beginEvent(log, EngineEvent::Event_Drop);
+    dropAndRefill(ev.drops, ev.cells);
+    M3_TRACE(Cat_Drop, Level_Debug, "drop %d moves, %d filled", int(ev.drops.size()), int(ev.cells.size()));
+    M3_TRACE_BOARD(Cat_Drop, "after drop", m_board);
+    commitEvent(log);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// 道具激活
+// ---------------------------------------------------------------------------
+
+void Match3Engine::schedule(int row, int col, int type, uint8_t color, int meta, int wave, int partner)
+{
+    const int idx = m_board.index(row, col);
+    if (m_pendingActivations.testAndSet(idx)) return;   // 已在队列中
+    m_nextWave.push_back({row, col, type, color, meta, wave, partner});
+}
+
+void Match3Engine::resolveActivations(EventLog &log)
+{
+    // 一次算完整个激活图：逐层执行，同层按触发顺序
+    while (!m_nextWave.empty()) {
+        m_wave.swap(m_nextWave);
+        m_nextWave.clear();
+        LatencyRecorder::Scope timing(m_latency, LatencyRecorder::Phase_Wave, m_wave.front().wave);
+        M3_TRACE(Cat_Prop, Level_Debug, "wave %d: %d activations", m_wave.front().wave, int(m_wave.size()));
+        // 按下标遍历并拷贝：超级+超级清盘时会清空 m_wave 以取消本层剩余激活
+        for (size_t i = 0; i < m_wave.size(); ++i) {
+            const Activation a = m_wave[i];
+            m_pendingActivations.reset(m_board.index(a.row, a.col));
+
+            EngineEvent &ev = beginEvent(log, EngineEvent::Event_Activate);
+            ev.row = a.row;
+            ev.col = a.col;
+            ev.propType = a.type;
+            ev.color = a.color;
+            ev.meta = a.meta;
+            ev.wave = a.wave;
+            execute(a, ev);
+            M3_TRACE(Cat_Prop, Level_Debug, "activate type %d at (%d,%d) wave %d", a.type, a.row, a.col, a.wave);
+            commitEvent(log);
+        }
+    }
+    m_wave.clear();
+}
+
+void Match3Engine::prepareMasks(const PropEffect &effect)
+{
+    if (effect.action != Action_Hit) return;
+    m_masks.prepare(effect.shape, effect.param);
+    if (effect.transposeOnMeta) m_masks.prepare(transposedShape(effect.shape), effect.param);
+}
+
+// 效果范围内的格子：普通方块直接清除，道具排入下一层激活（本次不清除）
+void Match3Engine::hitCell(int row, int col, int wave, std::vector<int> &cleared)
+{
+    const int idx = m_board.index(row, col);
+    const uint8_t v = m_board.at(row, col);
+    if (v == Tile_Empty || m_pendingActivations.test(idx)) return;
+
+    if (v == Tile_Bomb) {
+        schedule(row, col, BombType, Tile_Empty, 0, wave + 1);
+    } else if (tileIsRocket(v)) {
+        schedule(row, col, rocketTypeOf(v), Tile_Empty, 0, wave + 1);
+    } else if (v == Tile_SuperItem) {
+        schedule(row, col, SuperItemType, chooseNearbyColor(row, col), 0, wave + 1);
+    } else {
+        m_board.set(row, col, Tile_Empty);
+        cleared.push_back(idx);
+    }
+}
+
+// 消耗激活器自身，避免其在后续下落/匹配中再次被激活
+void Match3Engine::consume(int row, int col)
+{
+    if (!m_board.contains(row, col)) return;
+    m_board.set(row, col, Tile_Empty);
+    m_pendingActivations.reset(m_board.index(row, col));
+}
+
+void Match3Engine::execute(const Activation &a, EngineEvent &ev)
+{
+    const PropEffect *effect = findPropEffect(m_effects, a.type);
+    if (!effect) return;
+
+    // 组合：两个参与格都被消耗
+    if (a.partner >= 0) consume(a.partner / m_columns, a.partner % m_columns);
+    if (effect->consumeSelf) consume(a.row, a.col);
+
+    // 选色类效果：交换时为对方颜色，否则从四邻就近选择；无色可选则什么也不做
+    uint8_t chosen = Tile_Empty;
+    if (effect->color != Color_None) {
+        chosen = (effect->color == Color_GivenOrNearby && tileIsColor(a.color)) ? a.color
+                                                                                : chooseNearbyColor(a.row, a.col);
+        ev.color = chosen;
+        if (chosen == Tile_Empty) return;
+    }
+
+    switch (effect->action) {
+    case Action_Hit: {
+        const EffectShape shape = (effect->transposeOnMeta && a.meta != Rocket_UpDownType)
+                                      ? transposedShape(effect->shape) : effect->shape;
+        m_masks.forEach(shape, effect->param, a.row, a.col, [&](int r, int c) {
+            hitCell(r, c, a.wave, ev.cells);
+        });
+        break;
+    }
+    case Action_ClearColor:
+        // 清除全盘该颜色的普通方块（保留道具）
+        for (int i = 0; i < m_board.size(); ++i) {
+            if (m_board.data()[i] == chosen) {
+                m_board.set(i / m_columns, i % m_columns, Tile_Empty);
+                ev.cells.push_back(i);
+            }
+        }
+        break;
+    case Action_ConvertBombs:
+    case Action_ConvertRockets: {
+        const bool toBombs = effect->action == Action_ConvertBombs;
+        for (int i = 0; i < m_board.size(); ++i) {
+            if (m_board.data()[i] != chosen) continue;
+            const uint8_t code = toBombs ? uint8_t(Tile_Bomb)
+                                         : uint8_t(randomBounded(2) == 0 ? Tile_RocketUpDown : Tile_RocketLeftRight);
+            m_board.set(i / m_columns, i % m_columns, code);
+            ev.cells.push_back(i);
+        }
+        // 转化出的道具全部排入下一层激活
+        for (int idx : ev.cells) {
+            const int r = idx / m_columns, c = idx % m_columns;
+            schedule(r, c, toBombs ? BombType : rocketTypeOf(m_board.at(r, c)), Tile_Empty, 0, a.wave + 1);
+        }
+        break;
+    }
+    case Action_Wipe:
+        // 清空全盘；排队中的激活已无对象，一并取消
+        for (int i = 0; i < m_board.size(); ++i) {
+            if (m_board.data()[i] != Tile_Empty) {
+                m_board.set(i / m_columns, i % m_columns, Tile_Empty);
+                ev.cells.push_back(i);
+            }
+        }
+        m_wave.clear();
+        m_nextWave.clear();
+        m_pendingActivations.clear();
+        break;
+    }
+    addScore(int(ev.cells.size()));
+    m_counters.stats[effect->stat]++;
+}
+
+// ---------------------------------------------------------------------------
+// 下落与补位
+// ---------------------------------------------------------------------------
+
+void Match3Engine::dropAndRefill(std::vector<DropMove> &drops, std::vector<int> &spawned)
+{
+    drops.clear();
+    spawned.clear();
+    for (int c = 0; c < m_columns; ++c) settleColumn(c, drops, spawned);
+}
+
+// 单列重力内核：自底向上逐段压实（不可移动的格子把一列分成互不影响的段），
+// 随后自上而下给段顶的空位补入新色。一次遍历同时完成下落、补位和记录：
+// 下落轨迹按自底向上写入 drops，补位格按段内自上而下写入 spawned。
+// 每格至多写一次：搬走的方块不必先清空，源格要么被后续下落覆盖，要么落在段顶被补位覆盖。
+// 各列互不依赖，但补位颜色按列顺序取自带种子的随机数，为保证整局可复现按列顺序执行
+void Match3Engine::settleColumn(int col, std::vector<DropMove> &drops, std::vector<int> &spawned)
+{
+    int r = m_rows - 1;
+    while (r >= 0) {
+        // 跳过不可移动(块)位置
+        const uint8_t top = m_board.at(r, col);
+        if (top != Tile_Empty && !tileIsMovable(top)) {
+            r--;
+            continue;
+        }
+        int writeRow = r;
+        for (; r >= 0; --r) {
+            const uint8_t v = m_board.at(r, col);
+            if (v == Tile_Empty) continue;
+            if (!tileIsMovable(v)) break;
+            if (r != writeRow) {
+                m_board.set(writeRow, col, v);
+                drops.push_back({col, r, writeRow});
+            }
+            writeRow--;
+        }
+        // 区段 [r + 1, writeRow] 为空位，自上而下补位
+        for (int rr = r + 1; rr <= writeRow; ++rr) {
+            m_board.set(rr, col, randomColor());
+            spawned.push_back(m_board.index(rr, col));
+        }
+    }
+}
@@ -0,0 +1,259 @@
+﻿#ifndef MATCH3ENGINE_H
+#define MATCH3ENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "CellBitset.h"
+#include "LatencyRecorder.h"
+#include "GameRng.h"
+#include "TileGrid.h"
+#include "MatchFinder.h"
+#include "MoveFinder.h"
+#include "PropEffects.h"
+
+// 统计下标（与 GameBoard::stats / QML 统计面板一致）
+// 0-5 = 六种颜色被消除的格子数，其余为道具/组合触发次数
+enum StatIndex
+{
+    Stat_ColorFirst   = 0,
+    Stat_Rocket       = 6,
+    Stat_Bomb         = 7,
+    Stat_SuperItem    = 8,
+    Stat_RocketRocket = 9,
+    Stat_BombBomb     = 10,
+    Stat_BombRocket   = 11,
+    Stat_SuperRocket  = 12,
+    Stat_SuperBomb    = 13,
+    Stat_SuperSuper   = 14,
+    StatCount         = 15
+};
+
+// 每个事件完成后的计数快照，回放时直接用于刷新分数/步数/连击/统计
+struct EngineCounters
+{
+    int score = 0;
+    int steps = 0;
+    int combo = 0;
+    int stats[StatCount] = {0};
+    bool gameOver = false;      // 本事件使步数从 1 变为 0
+};
+
+// 一次下落：第 col 列的方块从 fromRow 落到 toRow
+struct DropMove
+{
+    int col;
+    int fromRow;
+    int toRow;
+};
+
+// 一条结构化事件，board 为事件生效后的棋盘快照
+struct EngineEvent
+{
+    enum Kind
+    {
+        Event_Swap,       // 交换已生效（row/col 与 row2/col2 为两端）
+        Event_Rollback,   // 无效交换被换回
+        Event_Match,      // 三消：cells 为被消除格子，props 为同时生成的道具
+        Event_Activate,   // 道具/组合激活：propType 为 1~4 或 100~105，cells 为被直接清除的格子
+        Event_Drop,       // 重力下落 + 补位：drops 为下落轨迹，cells 为新补入的格子
+        Event_Shuffle     // 结算后已无可走步，自动重排：meta 为局部修复次数
+    };
+
+    Kind kind = Event_Swap;
+    int row = 0;
+    int col = 0;
+    int row2 = 0;
+    int col2 = 0;
+    int propType = 0;
+    uint8_t color = Tile_Empty;   // 超级道具的目标颜色（可能为空，表示激活时再选）
+    int meta = 0;                 // 炸弹+火箭组合中火箭的类型
+    int wave = 0;                 // 连锁层级：0 为直接触发，n 为第 n 层被波及的道具
+    std::vector<int> cells;       // TileGrid 下标
+    std::vector<PropPlacement> props;
+    std::vector<DropMove> drops;
+    EngineCounters counters;
+    TileGrid board;
+
+    // 复位为一条新事件；cells/props/drops 与棋盘快照的已分配缓冲保留复用
+    void reset(Kind k);
+};
+
+// 事件日志：clear() 只把长度归零，已分配的事件（连同各自的 cells/drops/棋盘快照缓冲）
+// 留给下一步复用。调用方跨步复用同一个日志时，热身后整步结算不再向堆申请内存
+class EventLog
+{
+public:
+    typedef std::vector<EngineEvent>::iterator iterator;
+    typedef std::vector<EngineEvent>::const_iterator const_iterator;
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    void clear() { m_size = 0; }
+    void swap(EventLog &other) { m_events.swap(other.m_events); std::swap(m_size, other.m_size); }
+
+    // 追加一条 kind 类型的事件：优先复用已分配的槽位
+    EngineEvent &append(EngineEvent::Kind kind);
+    // 预先备好至少 events 个槽位，各自的缓冲与快照按 board 的尺寸分配；
+    // 之后事件数不超过 events 的结算从第一步起就不再分配
+    void reserve(size_t events, const TileGrid &board);
+
+    EngineEvent &operator[](size_t i) { return m_events[i]; }
+    const EngineEvent &operator[](size_t i) const { return m_events[i]; }
+    EngineEvent &back() { return m_events[m_size - 1]; }
+    const EngineEvent &back() const { return m_events[m_size - 1]; }
+    iterator begin() { return m_events.begin(); }
+    iterator end() { return m_events.begin() + std::ptrdiff_t(m_size); }
+    const_iterator begin() const { return m_events.begin(); }
+    const_iterator end() const { return m_events.begin() + std::ptrdiff_t(m_size); }
+
+private:
+    std::vector<EngineEvent> m_events;
+    size_t m_size = 0;
+};
+
+// 无 Qt 依赖的三消核心：不依赖事件循环和定时器，一次调用同步结算完整的一步
+// （交换、三消、道具生成、连锁激活、下落与补位直至棋盘稳定），并输出事件日志。
+// GameBoard 只负责把事件日志按 QML 的动画节奏回放成信号
+class Match3Engine
+{
+public:
+    // seed 决定棋盘生成、补位与道具随机性：相同种子 + 相同操作序列逐位复现整局
+    Match3Engine(int rows = 8, int columns = 8, MatchFinder::Backend backend = MatchFinder::Backend_Scalar,
+                 uint64_t seed = 0);
+
+    // 棋盘与计数
+    // 构造式生成：逐格只选不会与左/上两格成三连的颜色，再局部修复出至少一个可走步。
+    // 返回局部修复次数（重染一格或埋入一个可走步各算一次），耗时有上界
+    int newBoard();
+    // 打乱普通颜色（道具不动），再局部修复：只重染仍成三连的格子，必要时埋入一个可走步。
+    // 返回局部修复次数
+    int shuffle();
+    int lastRepairIterations() const { return m_lastRepairIterations; }
+    void resetCounters(int steps);
+    void setSteps(int steps) { m_counters.steps = steps; }
+    void setTile(int row, int col, uint8_t code) { m_board.set(row, col, code); }
+    void reseed(uint64_t seed) { m_rng.reseed(seed); }
+    uint64_t seed() const { return m_rng.seed(); }
+    // 圆形爆炸（炸弹 / 炸弹+炸弹，或表中其他 Disk 形状的效果）的半径，供策划调参；
+    // 类型不是圆形爆炸或半径为负时返回 false。可走步的预计清除数随之更新
+    bool setBlastRadius(int type, int radius);
+    int blastRadius(int type) const;     // 非圆形爆炸返回 -1
+    // 调试用：每次增量检测都与全盘扫描比对
+    void setCrossCheck(bool enabled) { m_matchFinder.setCrossCheck(enabled); }
+    // 分阶段计时（检测、道具、每层激活、下落补位、自动重排）写入 recorder；为空时不计时。不持有
+    void setLatencyRecorder(LatencyRecorder *recorder) { m_latency = recorder; }
+
+    const TileGrid &board() const { return m_board; }
+    const EngineCounters &counters() const { return m_counters; }
+    int rows() const { return m_rows; }
+    int columns() const { return m_columns; }
+
+    // 行动
+    bool isValidSwap(int r1, int c1, int r2, int c2) const;
+    // 所有会产生效果的交换（三消或道具激活）及预计直接清除数；
+    // 缓存按上一步改动过的行/列增量更新，棋盘未变时直接返回缓存
+    const std::vector<MoveHint> &availableMoves() const;
+    bool hasAvailableMoves() const;
+    // 执行一次交换并结算到稳定；交换不合法时返回 false 且不产生事件
+    bool playSwap(int r1, int c1, int r2, int c2, EventLog &log);
+    // 直接激活棋盘上的单体道具（双击），type 为 1~4，color 仅对超级道具有效
+    bool activateProp(int row, int col, int type, uint8_t color, EventLog &log);
+
+    // 快照：计数、随机数状态与棋盘编码排成一段平坦字节（定长头部 + 每格一字节），
+    // 用于撤销/重做、搜索试走和回退试探性的结算。只在两步之间（没有进行中的结算）保存与恢复
+    size_t snapshotSize() const;
+    void saveSnapshot(uint8_t *out) const;
+    // 恢复是一次头部拷贝加逐行比较拷贝，检测缓存只重扫有差异的行列；棋盘尺寸不符时返回 false 且不修改
+    bool restoreSnapshot(const uint8_t *in);
+
+    // 检测接口（初始化/打乱及外部工具使用）
+    bool hasMatches();
+    // 对当前棋盘做一次下落补位（不产生事件、不计分、不结算三消），供基准等外部工具单独测量重力内核
+    void dropAndRefill(std::vector<DropMove> &drops, std::vector<int> &spawned);
+
+private:
+    struct Activation
+    {
+        int row;
+        int col;
+        int type;
+        uint8_t color;
+        int meta;
+        int wave;
+        int partner;    // 组合的另一参与格下标，单体为 -1
+    };
+
+    int randomBounded(int n) { return m_rng.bounded(n); }
+    uint8_t randomColor() { return uint8_t(Tile_Red + randomBounded(TileColorCount)); }
+    uint8_t chooseNearbyColor(int row, int col);
+    static int rocketTypeOf(uint8_t tile) { return tile == Tile_RocketUpDown ? Rocket_UpDownType : Rocket_LeftRightType; }
+
+    void spendStep();
+    void addScore(int cleared) { m_counters.score += cleared * 10; }
+    // 在日志末尾开一条事件（复用槽位，首次按棋盘大小预留缓冲），填好后由 commitEvent 写入计数与棋盘快照
+    EngineEvent &beginEvent(EventLog &log, EngineEvent::Kind kind);
+    void commitEvent(EventLog &log);
+    void commitSwapEvent(EventLog &log, EngineEvent::Kind kind, int r1, int c1, int r2, int c2);
+
+    // 结算
+    void resolve(EventLog &log, bool matchPending, int r1, int c1, int r2, int c2);
+    bool resolveMatches(EventLog &log, int r1, int c1, int r2, int c2);
+    void resolveActivations(EventLog &log);
+    bool settle(EventLog &log);
+
+    // 三消与道具
+    void collectMatches(int r1, int c1, int r2, int c2, bool withProps);
+
+    // 道具激活
+    void schedule(int row, int col, int type, uint8_t color, int meta, int wave, int partner = -1);
+    void hitCell(int row, int col, int wave, std::vector<int> &cleared);
+    void consume(int row, int col);
+    // 查 PropEffects 表执行：消耗参与格 -> 选色 -> 按作用区域/颜色集合作用 -> 计分与统计
+    void execute(const Activation &a, EngineEvent &ev);
+    void prepareMasks(const PropEffect &effect);
+
+    // 生成与修复
+    bool formsRun(int row, int col, uint8_t color) const;   // 把 (row, col) 染成 color 是否会成三连
+    bool pickSafeColor(int row, int col, uint8_t &color);   // 随机挑一个不会成三连的颜色
+    int repairMatches(const std::vector<int> &pinned);
+    int ensureMove();
+    bool plantMove(std::vector<int> &pinned);
+
+    // 下落与补位：单列一次完成压实、补位并输出下落轨迹 / 补位格
+    void settleColumn(int col, std::vector<DropMove> &drops, std::vector<int> &spawned);
+
+    int m_rows;
+    int m_columns;
+    TileGrid m_board;
+    MatchFinder m_matchFinder;
+    ShapeMasks m_masks;                // 道具作用区域：按中心裁剪的行/列跨度与圆形跨度
+    std::vector<PropEffect> m_effects; // 本局的效果表（默认表的副本）
+    mutable MoveFinder m_moveFinder;   // 可走步缓存，只在查询时与棋盘同步
+    GameRng m_rng;
+    EngineCounters m_counters;
+    int m_lastRepairIterations = 0;
+    LatencyRecorder *m_latency = nullptr;
+
+    // 本次检测结果（下标 / 道具位置），跨次复用
+    std::vector<int> m_matchCells;
+    std::vector<PropPlacement> m_rocketScratch;
+    std::vector<PropPlacement> m_superScratch;
+    std::vector<int> m_bombScratch;
+    std::vector<PropPlacement> m_createdProps;
+
+    // 波前调度：m_wave 为正在执行的一层，执行中被波及的道具进入 m_nextWave，
+    // 一层执行完再整体换入，事件日志因此按连锁层级（wave）非递减排列
+    std::vector<Activation> m_wave;
+    std::vector<Activation> m_nextWave;
+    CellBitset m_pendingActivations;   // 已排队但尚未执行的激活格子，避免重复激活
+
+    // 打乱 / 埋步的暂存，跨次复用
+    std::vector<int> m_shuffleCells;
+    std::vector<uint8_t> m_shuffleColors;
+    std::vector<int> m_pinned;
+};
+
+#endif // MATCH3ENGINE_H
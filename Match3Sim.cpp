@@ -0,0 +1,153 @@
+﻿#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "RunScanner.h"
+#include "Simulator.h"
+
+// 批量蒙特卡洛模拟：并行跑 N 局带种子的对局，汇总得分、连锁深度与 15 项统计，
+// 用于平衡步数（m_init_step）和道具规则
+namespace {
+const char *const StatNames[StatCount] = {
+    "red", "green", "blue", "yellow", "purple", "brown",
+    "rocket", "bomb", "super",
+    "rocket+rocket", "bomb+bomb", "bomb+rocket",
+    "super+rocket", "super+bomb", "super+super"
+};
+
+void printUsage(const char *argv0)
+{
+    std::printf("usage: %s [options]\n"
+                "  --games N       number of games (default 1000)\n"
+                "  --threads N     worker threads, 0 = all cores (default 0)\n"
+                "  --seed S        base seed (default 1)\n"
+                "  --steps N       steps per game (default 25)\n"
+                "  --rows N        board rows (default 8)\n"
+                "  --columns N     board columns (default 8)\n"
+                "  --policy NAME   move policy:", argv0);
+    for (const std::string &name : policyNames()) std::printf(" %s", name.c_str());
+    std::printf(" (default random)\n"
+                "  --backend NAME  scalar | bitboard | simd (default scalar)\n"
+                "  --depth N       expectimax: search depth in swaps (default 2)\n"
+                "  --samples N     expectimax: refill samples per swap (default 3)\n"
+                "  --branch N      expectimax: swaps expanded below the root (default 8)\n"
+                "  --budget-ms N   expectimax: time budget per move, 0 = none (default 0)\n"
+                "  --max-allocs N  fail if moves after warm-up allocate more than N times (default -1 = off)\n");
+}
+
+bool parseArgs(int argc, char *argv[], SimConfig &config)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0) return false;
+        if (!value) {
+            std::fprintf(stderr, "missing value for %s\n", arg);
+            return false;
+        }
+        ++i;
+        if (std::strcmp(arg, "--games") == 0) config.games = std::atoi(value);
+        else if (std::strcmp(arg, "--threads") == 0) config.threads = std::atoi(value);
+        else if (std::strcmp(arg, "--seed") == 0) config.seed = std::strtoull(value, nullptr, 0);
+        else if (std::strcmp(arg, "--steps") == 0) config.steps = std::atoi(value);
+        else if (std::strcmp(arg, "--rows") == 0) config.rows = std::atoi(value);
+        else if (std::strcmp(arg, "--columns") == 0) config.columns = std::atoi(value);
+        else if (std::strcmp(arg, "--policy") == 0) config.policy = value;
+        else if (std::strcmp(arg, "--max-allocs") == 0) config.maxAllocations = std::atoll(value);
+        else if (std::strcmp(arg, "--depth") == 0) config.solver.maxDepth = std::atoi(value);
+        else if (std::strcmp(arg, "--samples") == 0) config.solver.samples = std::atoi(value);
+        else if (std::strcmp(arg, "--branch") == 0) config.solver.maxBranch = std::atoi(value);
+        else if (std::strcmp(arg, "--budget-ms") == 0) config.solver.budgetMs = std::atoi(value);
+        else if (std::strcmp(arg, "--backend") == 0) {
+            if (std::strcmp(value, "scalar") == 0) config.backend = MatchFinder::Backend_Scalar;
+            else if (std::strcmp(value, "bitboard") == 0) config.backend = MatchFinder::Backend_Bitboard;
+            else if (std::strcmp(value, "simd") == 0) config.backend = MatchFinder::Backend_Simd;
+            else {
+                std::fprintf(stderr, "unknown backend: %s\n", value);
+                return false;
+            }
+        } else {
+            std::fprintf(stderr, "unknown option: %s\n", arg);
+            return false;
+        }
+    }
+    if (config.games <= 0 || config.rows < 3 || config.columns < 3 || config.steps <= 0) {
+        std::fprintf(stderr, "games/steps must be positive and the board at least 3x3\n");
+        return false;
+    }
+    if (config.backend == MatchFinder::Backend_Bitboard && !ColorBitboard::supports(config.rows, config.columns)) {
+        std::fprintf(stderr, "bitboard backend supports boards up to %dx%d\n", ColorBitboard::MaxSide, ColorBitboard::MaxSide);
+        return false;
+    }
+    const SolverConfig &solver = config.solver;
+    if (solver.maxDepth < 1 || solver.samples < 1 || solver.maxBranch < 1 || solver.budgetMs < 0) {
+        std::fprintf(stderr, "depth/samples/branch must be positive and budget-ms non-negative\n");
+        return false;
+    }
+    if (!makePolicy(config.policy)) {
+        std::fprintf(stderr, "unknown policy: %s\n", config.policy.c_str());
+        return false;
+    }
+    return true;
+}
+
+int percentile(const std::vector<int> &sorted, double p)
+{
+    if (sorted.empty()) return 0;
+    const size_t idx = size_t(p * double(sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+}
+
+int main(int argc, char *argv[])
+{
+    SimConfig config;
+    if (!parseArgs(argc, argv, config)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (config.backend == MatchFinder::Backend_Simd) {
+        std::printf("simd isa       : %s\n", RunScanner::isaName(RunScanner::activeIsa()));
+    }
+
+    const SimSummary s = runSimulation(config);
+
+    std::vector<int> sorted = s.scores;
+    std::sort(sorted.begin(), sorted.end());
+    double mean = 0.0;
+    for (int v : sorted) mean += v;
+    mean /= double(sorted.size());
+    double var = 0.0;
+    for (int v : sorted) var += (v - mean) * (v - mean);
+    const double stddev = std::sqrt(var / double(sorted.size()));
+    const double games = double(s.games);
+
+    std::printf("games          : %d (%s policy, %dx%d board, %d steps, seed %llu)\n",
+                s.games, config.policy.c_str(), config.rows, config.columns, config.steps,
+                static_cast<unsigned long long>(config.seed));
+    std::printf("threads        : %d\n", s.threads);
+    std::printf("elapsed        : %.3f s (%.1f games/s)\n", s.seconds, s.gamesPerSecond());
+    std::printf("score          : mean %.1f  stddev %.1f  min %d  p10 %d  p50 %d  p90 %d  max %d\n",
+                mean, stddev, sorted.front(), percentile(sorted, 0.1), percentile(sorted, 0.5),
+                percentile(sorted, 0.9), sorted.back());
+    std::printf("moves/game     : %.2f\n", double(s.totalMoves) / games);
+    std::printf("shuffles/game  : %.3f\n", double(s.totalShuffles) / games);
+    std::printf("cascade depth  : mean %.3f per move, max %d\n",
+                s.totalMoves ? double(s.totalCascadeRounds) / double(s.totalMoves) : 0.0, s.maxCascade);
+    std::printf("allocs/move    : %.4f over %lld moves after %d warm-up moves per game\n",
+                s.steadyMoves ? double(s.steadyAllocations) / double(s.steadyMoves) : 0.0, s.steadyMoves,
+                config.warmupMoves);
+    std::printf("stats (total / per game)\n");
+    for (int k = 0; k < StatCount; ++k) {
+        std::printf("  %2d %-14s %12lld %10.3f\n", k, StatNames[k], s.stats[k], double(s.stats[k]) / games);
+    }
+    if (config.maxAllocations >= 0 && s.steadyAllocations > config.maxAllocations) {
+        std::fprintf(stderr, "steady-state allocations %lld exceed the limit %lld\n",
+                     s.steadyAllocations, config.maxAllocations);
+        return 2;
+    }
+    return 0;
+}
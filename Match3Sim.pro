@@ -0,0 +1,47 @@
+# 控制台蒙特卡洛模拟器：只依赖无 Qt 的结算核心，多线程批量跑带种子的对局
+TEMPLATE = app
+TARGET = Match3Sim
+CONFIG += console c++17 thread
+CONFIG -= app_bundle qt
+
+SOURCES += \
+        AllocCounter.cpp \
+        ColorBitboard.cpp \
+        LatencyRecorder.cpp \
+        Match3Engine.cpp \
+        Match3Sim.cpp \
+        MatchFinder.cpp \
+        MoveFinder.cpp \
+        MoveSolver.cpp \
+        PropEffects.cpp \
+        RunScanner.cpp \
+        Simulator.cpp \
+        Trace.cpp
+
+HEADERS += \
+    AllocCounter.h \
+    CellBitset.h \
+    ColorBitboard.h \
+    GameRng.h \
+    LatencyRecorder.h \
+    Match3Engine.h \
+    MatchFinder.h \
+    MoveFinder.h \
+    MoveSolver.h \
+    PropEffects.h \
+    RunScanner.h \
+    Simulator.h \
+    TileGrid.h \
+    Trace.h
+
+# 分配回归检查：链接后按固定种子（1..200）在每个检测后端上跑一批对局，热身后任何一步出现堆分配
+# 即以非零退出码使构建失败（Match3Sim --max-allocs 0）。交叉编译或 CONFIG+=no_alloc_check 时跳过
+!cross_compile:!no_alloc_check {
+    win32: ALLOC_CHECK_BIN = $(DESTDIR_TARGET)
+    else: ALLOC_CHECK_BIN = ./$(TARGET)
+    ALLOC_CHECK_BACKENDS = scalar bitboard simd
+    for(backend, ALLOC_CHECK_BACKENDS) {
+        !isEmpty(QMAKE_POST_LINK): QMAKE_POST_LINK += &&
+        QMAKE_POST_LINK += $$ALLOC_CHECK_BIN --games 200 --seed 1 --backend $$backend --max-allocs 0 > $$QMAKE_SYSTEM_NULL_DEVICE
+    }
+}
@@ -0,0 +1,356 @@
+﻿#include "MatchFinder.h"
+#include "RunScanner.h"
+
+#include <cstdio>
+
+namespace {
+enum CellFlag : uint8_t {
+    Flag_Matched     = 0x01,
+    Flag_SuperCover  = 0x02,
+    Flag_SuperCenter = 0x04
+};
+
+bool sameRuns(const std::vector<MatchRun> &a, const std::vector<MatchRun> &b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].color != b[i].color || a[i].horizontal != b[i].horizontal || a[i].line != b[i].line
+            || a[i].start != b[i].start || a[i].length != b[i].length)
+            return false;
+    }
+    return true;
+}
+
+// 从“与下一格同色”位图中提取连续段：位图中连续 k 个 1 对应长度 k+1 的同色段。
+// 按字跳过全 0 / 全 1 区域，只在段边界处停下
+template <typename Emit>
+void runsFromEqualBits(const uint64_t *bits, int nbits, Emit emit)
+{
+    const int words = RunScanner::wordsFor(nbits);
+    int pos = 0;
+    while (pos < nbits) {
+        int w = pos >> 6;
+        uint64_t word = bits[w] & (~uint64_t(0) << (pos & 63));
+        while (!word) {
+            if (++w >= words) return;
+            word = bits[w];
+        }
+        const int start = (w << 6) + RunScanner::lowestBit(word);
+        // 找下一个 0：nbits 之后的位恒为 0，因此最后一个字内必然能停下
+        uint64_t inv = ~bits[w] & (~uint64_t(0) << (start & 63));
+        while (!inv && ++w < words) inv = ~bits[w];
+        const int end = inv ? (w << 6) + RunScanner::lowestBit(inv) : nbits;
+        if (end - start >= 2) emit(start, end - start + 1);
+        pos = end + 1;
+    }
+}
+}
+
+void MatchFinder::reset(const TileGrid &board)
+{
+    m_rows = board.rows();
+    m_columns = board.columns();
+    m_rowRuns.assign(size_t(m_rows), std::vector<MatchRun>());
+    m_colRuns.assign(size_t(m_columns), std::vector<MatchRun>());
+    m_cellFlags.assign(size_t(board.size()), 0);
+    m_flaggedCells.clear();
+
+    // 按尺寸上界一次预留（长为 n 的一行最多 n / 3 段），之后检测不再分配
+    for (std::vector<MatchRun> &runs : m_rowRuns) runs.reserve(size_t(m_columns / 3));
+    for (std::vector<MatchRun> &runs : m_colRuns) runs.reserve(size_t(m_rows / 3));
+    m_runs.reserve(size_t(m_rows * (m_columns / 3) + m_columns * (m_rows / 3)));
+    m_matchedCells.reserve(size_t(board.size()));
+    m_flaggedCells.reserve(size_t(board.size()));
+}
+
+void MatchFinder::scanRow(const TileGrid &board, int r)
+{
+    std::vector<MatchRun> &runs = m_rowRuns[size_t(r)];
+    runs.clear();
+    if (usingBitboard()) {
+        m_bitboard.appendLineRuns(board, true, r, runs);
+        return;
+    }
+    if (m_backend == Backend_Simd) {
+        if (m_columns < 3) return;
+        const uint8_t *row = board.rowData(r);
+        m_lineBits.resize(size_t(RunScanner::wordsFor(m_columns)));
+        RunScanner::adjacentEqualBits(row, m_columns, m_lineBits.data());
+        runsFromEqualBits(m_lineBits.data(), m_columns - 1, [&](int start, int length) {
+            runs.push_back({row[start], true, r, start, length});
+        });
+        return;
+    }
+    const uint8_t *row = board.rowData(r);
+    int c = 0;
+    while (c < m_columns) {
+        const uint8_t color = row[c];
+        int end = c + 1;
+        if (tileIsColor(color)) {
+            while (end < m_columns && row[end] == color) end++;
+            if (end - c >= 3) runs.push_back({color, true, r, c, end - c});
+        }
+        c = end;
+    }
+}
+
+void MatchFinder::scanColumn(const TileGrid &board, int c)
+{
+    std::vector<MatchRun> &runs = m_colRuns[size_t(c)];
+    runs.clear();
+    if (usingBitboard()) {
+        m_bitboard.appendLineRuns(board, false, c, runs);
+        return;
+    }
+    if (m_colBitsReady) {
+        runsFromEqualBits(m_colBits.data() + size_t(c) * size_t(m_colBitWords), m_rows - 1, [&](int start, int length) {
+            runs.push_back({board.at(start, c), false, c, start, length});
+        });
+        return;
+    }
+    int r = 0;
+    while (r < m_rows) {
+        const uint8_t color = board.at(r, c);
+        int end = r + 1;
+        if (tileIsColor(color)) {
+            while (end < m_rows && board.at(end, c) == color) end++;
+            if (end - r >= 3) runs.push_back({color, false, c, r, end - r});
+        }
+        r = end;
+    }
+}
+
+// SIMD 后端的列扫描：相邻两行整行比较（一次 16~32 列），再把结果转置成每列一条位图
+void MatchFinder::prepareColumnBits(const TileGrid &board)
+{
+    m_colBitsReady = false;
+    if (m_backend != Backend_Simd || m_rows < 3) return;
+    m_colBitWords = RunScanner::wordsFor(m_rows - 1);
+    m_colBits.assign(size_t(m_columns) * size_t(m_colBitWords), 0);
+    m_lineBits.resize(size_t(RunScanner::wordsFor(m_columns)));
+    for (int r = 0; r + 1 < m_rows; ++r) {
+        RunScanner::pairEqualBits(board.rowData(r), board.rowData(r + 1), m_columns, m_lineBits.data());
+        const uint64_t bit = uint64_t(1) << (r & 63);
+        for (int w = 0; w < int(m_lineBits.size()); ++w) {
+            uint64_t word = m_lineBits[size_t(w)];
+            while (word) {
+                const int c = (w << 6) + RunScanner::lowestBit(word);
+                word &= word - 1;
+                m_colBits[size_t(c) * size_t(m_colBitWords) + size_t(r >> 6)] |= bit;
+            }
+        }
+    }
+    m_colBitsReady = true;
+}
+
+void MatchFinder::rebuildRuns()
+{
+    m_runs.clear();
+    for (const std::vector<MatchRun> &line : m_rowRuns) m_runs.insert(m_runs.end(), line.begin(), line.end());
+    for (const std::vector<MatchRun> &line : m_colRuns) m_runs.insert(m_runs.end(), line.begin(), line.end());
+    clearFlags();
+    m_matchedValid = false;
+}
+
+void MatchFinder::scan(const TileGrid &board)
+{
+    reset(board);
+    if (usingBitboard()) m_bitboard.update(board);
+    // 行扫描：每行只走一遍，记录所有长度 >= 3 的同色段
+    for (int r = 0; r < m_rows; ++r) scanRow(board, r);
+    // 列扫描
+    prepareColumnBits(board);
+    for (int c = 0; c < m_columns; ++c) scanColumn(board, c);
+    m_colBitsReady = false;
+    rebuildRuns();
+    m_lastRescanned = m_rows + m_columns;
+    m_syncedVersion = board.version();
+    m_synced = true;
+}
+
+void MatchFinder::update(const TileGrid &board)
+{
+    if (!m_synced || board.rows() != m_rows || board.columns() != m_columns || board.version() < m_syncedVersion) {
+        scan(board);
+        return;
+    }
+    if (board.version() == m_syncedVersion) {
+        // 棋盘未变，连续段表及本轮标记保持不变
+        m_lastRescanned = 0;
+        return;
+    }
+    if (usingBitboard()) m_bitboard.update(board);
+    // 只有版本戳新于上次同步的行/列才可能出现新的或失效的连续段
+    int rescanned = 0;
+    for (int r = 0; r < m_rows; ++r) {
+        if (board.rowVersion(r) > m_syncedVersion) { scanRow(board, r); rescanned++; }
+    }
+    if (m_backend == Backend_Simd) {
+        // 改动列较多（如整盘下落）时按整行批量比较更划算，零星几列仍逐格扫描
+        int dirtyColumns = 0;
+        for (int c = 0; c < m_columns; ++c) {
+            if (board.colVersion(c) > m_syncedVersion) dirtyColumns++;
+        }
+        if (dirtyColumns * 4 >= m_columns) prepareColumnBits(board);
+    }
+    for (int c = 0; c < m_columns; ++c) {
+        if (board.colVersion(c) > m_syncedVersion) { scanColumn(board, c); rescanned++; }
+    }
+    m_colBitsReady = false;
+    m_lastRescanned = rescanned;
+    m_syncedVersion = board.version();
+    rebuildRuns();
+
+    if (m_crossCheck) {
+        MatchFinder full(Backend_Scalar);
+        full.scan(board);
+        if (!sameRuns(m_runs, full.m_runs)) {
+            std::fprintf(stderr, "MatchFinder: incremental scan diverged from full scan (%d vs %d runs), using full result\n",
+                         int(m_runs.size()), int(full.m_runs.size()));
+            m_rowRuns.swap(full.m_rowRuns);
+            m_colRuns.swap(full.m_colRuns);
+            rebuildRuns();
+        }
+    }
+}
+
+void MatchFinder::clearFlags()
+{
+    for (int idx : m_flaggedCells) m_cellFlags[size_t(idx)] = 0;
+    m_flaggedCells.clear();
+}
+
+void MatchFinder::setFlag(int idx, uint8_t flag)
+{
+    uint8_t &f = m_cellFlags[size_t(idx)];
+    if (f == 0) m_flaggedCells.push_back(idx);
+    f |= flag;
+}
+
+const std::vector<int> &MatchFinder::matchedCells()
+{
+    if (m_matchedValid) return m_matchedCells;
+    m_matchedCells.clear();
+    for (const MatchRun &run : m_runs) {
+        for (int k = 0; k < run.length; ++k) {
+            const int idx = run.horizontal ? run.line * m_columns + run.start + k
+                                           : (run.start + k) * m_columns + run.line;
+            if (m_cellFlags[size_t(idx)] & Flag_Matched) continue;
+            setFlag(idx, Flag_Matched);
+            m_matchedCells.push_back(idx);
+        }
+    }
+    m_matchedValid = true;
+    return m_matchedCells;
+}
+
+const MatchRun *MatchFinder::runThrough(bool horizontal, int line, int pos) const
+{
+    const std::vector<MatchRun> &runs = horizontal ? m_rowRuns[size_t(line)] : m_colRuns[size_t(line)];
+    for (const MatchRun &run : runs) {
+        if (pos >= run.start && pos < run.start + run.length) return &run;
+    }
+    return nullptr;
+}
+
+// 将穿过 pos 的某条五连以上连续段中、以 pos 为中心（边界处截断）的 5 格窗口标记为覆盖
+void MatchFinder::coverSuperWindow(const MatchRun *run, int pos)
+{
+    if (!run || run->length < 5) return;
+    int start = pos - 2;
+    if (start < run->start) start = run->start;
+    if (start > run->start + run->length - 5) start = run->start + run->length - 5;
+    for (int k = start; k < start + 5; ++k) {
+        const int idx = run->horizontal ? run->line * m_columns + k : k * m_columns + run->line;
+        setFlag(idx, Flag_SuperCover);
+    }
+}
+
+void MatchFinder::findProps(int r1, int c1, int r2, int c2,
+                            std::vector<PropPlacement> &rockets,
+                            std::vector<PropPlacement> &superItems)
+{
+    rockets.clear();
+    superItems.clear();
+
+    // 五连：每个 5 格窗口在第三格生成超级道具，并记录其覆盖范围
+    for (const MatchRun &run : m_runs) {
+        for (int w = run.start; w + 5 <= run.start + run.length; ++w) {
+            const int row = run.horizontal ? run.line : w + 2;
+            const int col = run.horizontal ? w + 2 : run.line;
+            superItems.push_back({SuperItemType, row, col});
+            setFlag(row * m_columns + col, Flag_SuperCenter);
+        }
+    }
+    for (const PropPlacement &sp : superItems) {
+        coverSuperWindow(runThrough(true, sp.row, sp.col), sp.col);
+        coverSuperWindow(runThrough(false, sp.col, sp.row), sp.row);
+    }
+
+    // 四连：每个 4 格窗口生成一个火箭（横向四连 -> 竖向火箭，纵向四连 -> 横向火箭）
+    for (const MatchRun &run : m_runs) {
+        for (int w = run.start; w + 4 <= run.start + run.length; ++w) {
+            PropPlacement p;
+            if (run.horizontal) {
+                p.type = Rocket_UpDownType;
+                if (r1 == run.line && c1 >= w && c1 <= w + 3)      { p.row = r1; p.col = c1; }
+                else if (r2 == run.line && c2 >= w && c2 <= w + 3) { p.row = r2; p.col = c2; }
+                else                                               { p.row = run.line; p.col = w + 1; }
+            } else {
+                p.type = Rocket_LeftRightType;
+                if (c1 == run.line && r1 >= w && r1 <= w + 3)      { p.row = r1; p.col = c1; }
+                else if (c2 == run.line && r2 >= w && r2 <= w + 3) { p.row = r2; p.col = c2; }
+                else                                               { p.row = w + 1; p.col = run.line; }
+            }
+            // 落在五连覆盖格（含超级道具中心）上的火箭丢弃，避免与超级道具并存
+            if (m_cellFlags[size_t(p.row * m_columns + p.col)] & (Flag_SuperCover | Flag_SuperCenter)) continue;
+            rockets.push_back(p);
+        }
+    }
+}
+
+bool MatchFinder::isSuperCenter(int row, int col) const
+{
+    if (row < 0 || row >= m_rows || col < 0 || col >= m_columns) return false;
+    return m_cellFlags[size_t(row * m_columns + col)] & Flag_SuperCenter;
+}
+
+void MatchFinder::findBombCenters(const TileGrid &board, std::vector<int> &out) const
+{
+    out.clear();
+    if (usingBitboard()) {
+        m_bitboard.findBombCenters(out);
+        return;
+    }
+
+    // 所有 T/L 形的偏移模式（以交点/拐点为中心，{行偏移, 列偏移}）
+    static const int patterns[8][4][2] = {
+        {{0,-1},{0,1},{-1,0},{-2,0}},   // T 向上
+        {{0,-1},{0,1},{1,0},{2,0}},     // T 向下
+        {{-1,0},{1,0},{0,-1},{0,-2}},   // T 向左
+        {{-1,0},{1,0},{0,1},{0,2}},     // T 向右
+        {{0,-1},{0,-2},{1,0},{2,0}},    // L 交点在右上角
+        {{0,1},{0,2},{1,0},{2,0}},      // L 交点在左上角
+        {{0,1},{0,2},{-1,0},{-2,0}},    // L 交点在左下角
+        {{0,-1},{0,-2},{-1,0},{-2,0}}   // L 交点在右下角
+    };
+
+    for (int r = 0; r < m_rows; ++r) {
+        for (int c = 0; c < m_columns; ++c) {
+            const uint8_t color = board.at(r, c);
+            if (!tileIsColor(color)) continue;
+            for (const auto &pat : patterns) {
+                bool ok = true;
+                for (const auto &off : pat) {
+                    const int rr = r + off[0];
+                    const int cc = c + off[1];
+                    if (!board.contains(rr, cc) || board.at(rr, cc) != color) { ok = false; break; }
+                }
+                if (ok) {
+                    out.push_back(r * m_columns + c);
+                    break; // 一个中心点匹配到任一模式即可
+                }
+            }
+        }
+    }
+}
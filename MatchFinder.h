@@ -0,0 +1,112 @@
+﻿#ifndef MATCHFINDER_H
+#define MATCHFINDER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "TileGrid.h"
+#include "ColorBitboard.h"
+
+// 一条同色连续段（长度 >= 3），横向时 line 为行号，纵向时 line 为列号
+struct MatchRun
+{
+    uint8_t color;
+    bool horizontal;
+    int line;
+    int start;
+    int length;
+};
+
+// 道具生成位置（与 PropTypedef 对应，但不依赖 Qt）
+struct PropPlacement
+{
+    int type;
+    int row;
+    int col;
+};
+
+// 单遍扫描的三消检测器：一次行扫描 + 一次列扫描建立连续段表，
+// 三消格子、四连火箭、五连超级道具都从同一张表推导。
+// 连续段按行/列分别保存，update() 只重扫自上次同步以来版本戳变化过的行和列
+// （交换时即两格所在的行列，下落后即被重力/补位改动过的列及其涉及的行）
+// 构造时可选择逐格扫描或按颜色位棋盘两种后端，二者结果完全一致
+class MatchFinder
+{
+public:
+    enum Backend
+    {
+        Backend_Scalar,     // 逐格比较
+        Backend_Bitboard,   // 每色每行一个 64 位掩码，移位/按位与求连续段与 T/L 形（最大 64x64）
+        Backend_Simd        // SSE2/AVX2 一次比较 16~32 格求连续段边界，面向大尺寸棋盘
+    };
+
+    explicit MatchFinder(Backend backend = Backend_Scalar) : m_backend(backend) {}
+
+    Backend backend() const { return m_backend; }
+    // 实际生效的后端：棋盘超过 64x64 时位棋盘退回逐格扫描
+    bool usingBitboard() const { return m_backend == Backend_Bitboard && ColorBitboard::supports(m_rows, m_columns); }
+
+    // 全盘扫描，重建连续段表
+    void scan(const TileGrid &board);
+    // 增量扫描：只重扫被改动过的行/列，结果与 scan() 完全一致
+    void update(const TileGrid &board);
+
+    // 调试模式：每次 update() 后再做一次全盘扫描比对，不一致时输出差异并以全盘结果为准
+    void setCrossCheck(bool enabled) { m_crossCheck = enabled; }
+    bool crossCheck() const { return m_crossCheck; }
+
+    const std::vector<MatchRun> &runs() const { return m_runs; }
+    bool hasMatches() const { return !m_runs.empty(); }
+    int lastRescannedLines() const { return m_lastRescanned; }
+
+    // 所有被三消覆盖的格子（去重，按首次出现顺序），元素为 TileGrid 下标
+    const std::vector<int> &matchedCells();
+
+    // 从连续段表推导道具位置，规则与原先逐窗口检测一致：
+    // 每个长度为 5 的窗口在窗口第三格生成超级道具；
+    // 每个长度为 4 的窗口生成火箭，优先放在交换端点 1/2，否则放在窗口中点；
+    // 落在五连覆盖范围内的火箭被丢弃
+    void findProps(int r1, int c1, int r2, int c2,
+                   std::vector<PropPlacement> &rockets,
+                   std::vector<PropPlacement> &superItems);
+
+    // 某格是否为本次超级道具中心（炸弹与之冲突时需要让位）
+    bool isSuperCenter(int row, int col) const;
+
+    // T/L 形炸弹中心（5 格：交点 + 两条长度 3 的臂），按行优先顺序输出 TileGrid 下标。
+    // 需在 scan()/update() 之后调用
+    void findBombCenters(const TileGrid &board, std::vector<int> &out) const;
+
+private:
+    void reset(const TileGrid &board);
+    void scanRow(const TileGrid &board, int row);
+    void scanColumn(const TileGrid &board, int col);
+    void prepareColumnBits(const TileGrid &board);
+    void rebuildRuns();
+    void clearFlags();
+    void setFlag(int idx, uint8_t flag);
+    const MatchRun *runThrough(bool horizontal, int line, int pos) const;
+    void coverSuperWindow(const MatchRun *run, int pos);
+
+    Backend m_backend;
+    ColorBitboard m_bitboard;
+    int m_rows = 0;
+    int m_columns = 0;
+    bool m_synced = false;
+    bool m_crossCheck = false;
+    uint32_t m_syncedVersion = 0;
+    int m_lastRescanned = 0;
+    std::vector<std::vector<MatchRun>> m_rowRuns;   // 每行的横向连续段
+    std::vector<std::vector<MatchRun>> m_colRuns;   // 每列的纵向连续段
+    std::vector<MatchRun> m_runs;                   // 合并视图：先所有行，再所有列
+    std::vector<int> m_matchedCells;
+    std::vector<uint8_t> m_cellFlags;               // 按位标记：已匹配 / 五连覆盖 / 超级中心
+    std::vector<int> m_flaggedCells;                // 本轮被打过标记的格子，下轮只清这些
+    std::vector<uint64_t> m_lineBits;               // SIMD 后端：单行相邻同色位图
+    std::vector<uint64_t> m_colBits;                // SIMD 后端：按列转置的上下同色位图
+    int m_colBitWords = 0;
+    bool m_colBitsReady = false;
+    bool m_matchedValid = false;
+};
+
+#endif // MATCHFINDER_H
@@ -0,0 +1,258 @@
+﻿#include "MoveFinder.h"
+
+namespace {
+// 交换后的棋盘视图：只替换两端的值，不复制棋盘
+struct SwappedView
+{
+    const TileGrid &board;
+    int r1, c1, r2, c2;
+
+    uint8_t at(int r, int c) const {
+        if (r == r1 && c == c1) return board.at(r2, c2);
+        if (r == r2 && c == c2) return board.at(r1, c1);
+        return board.at(r, c);
+    }
+
+    // 交换后 (row, col) 所在横向/纵向同色段中被三消清除的格子数
+    int clearedAt(int row, int col) const {
+        const uint8_t v = at(row, col);
+        if (!tileIsColor(v)) return 0;
+        int left = col, right = col;
+        while (left > 0 && at(row, left - 1) == v) left--;
+        while (right + 1 < board.columns() && at(row, right + 1) == v) right++;
+        int top = row, bottom = row;
+        while (top > 0 && at(top - 1, col) == v) top--;
+        while (bottom + 1 < board.rows() && at(bottom + 1, col) == v) bottom++;
+        const int h = right - left + 1;
+        const int w = bottom - top + 1;
+        int cleared = 0;
+        if (h >= 3) cleared += h;
+        if (w >= 3) cleared += w;
+        if (h >= 3 && w >= 3) cleared--;   // 交点只算一次
+        return cleared;
+    }
+};
+
+int rocketTypeOf(uint8_t tile)
+{
+    return tile == Tile_RocketUpDown ? Rocket_UpDownType : Rocket_LeftRightType;
+}
+}
+
+void MoveFinder::reset(const TileGrid &board)
+{
+    m_rows = board.rows();
+    m_columns = board.columns();
+    m_slots.assign(size_t(board.size()) * 2, Slot());
+    m_slotStamp.assign(m_slots.size(), 0);
+    m_moves.reserve(m_slots.size());
+    m_validSlots = 0;
+    m_movesValid = false;
+}
+
+void MoveFinder::scan(const TileGrid &board)
+{
+    reset(board);
+    for (int s = 0; s < int(m_slots.size()); ++s) evaluate(board, s);
+    m_lastReevaluated = int(m_slots.size());
+    m_syncedVersion = board.version();
+    m_synced = true;
+}
+
+void MoveFinder::update(const TileGrid &board)
+{
+    if (!m_synced || board.rows() != m_rows || board.columns() != m_columns || board.version() < m_syncedVersion) {
+        scan(board);
+        return;
+    }
+    if (board.version() == m_syncedVersion) {
+        m_lastReevaluated = 0;
+        return;
+    }
+
+    // 改动过的行：该行的横向槽位 + 起止于该行的纵向槽位；改动过的列同理
+    ++m_stamp;
+    int reevaluated = 0;
+    auto touch = [&](int row, int col, int dir) {
+        if (row < 0 || col < 0) return;
+        const int s = (row * m_columns + col) * 2 + dir;
+        if (m_slotStamp[size_t(s)] == m_stamp) return;
+        m_slotStamp[size_t(s)] = m_stamp;
+        evaluate(board, s);
+        reevaluated++;
+    };
+    for (int r = 0; r < m_rows; ++r) {
+        if (board.rowVersion(r) <= m_syncedVersion) continue;
+        for (int c = 0; c < m_columns; ++c) {
+            touch(r, c, 0);
+            touch(r, c, 1);
+            touch(r - 1, c, 1);
+        }
+    }
+    for (int c = 0; c < m_columns; ++c) {
+        if (board.colVersion(c) <= m_syncedVersion) continue;
+        for (int r = 0; r < m_rows; ++r) {
+            touch(r, c, 1);
+            touch(r, c, 0);
+            touch(r, c - 1, 0);
+        }
+    }
+    m_lastReevaluated = reevaluated;
+    m_syncedVersion = board.version();
+    m_movesValid = false;   // 超级道具的清除数依赖全盘颜色计数，列表需重新汇总
+}
+
+void MoveFinder::setBlastRadii(int bomb, int bombBomb)
+{
+    if (bomb == m_bombDisk.radius && bombBomb == m_bombBombDisk.radius) return;
+    m_bombDisk = DiskSpans(bomb);
+    m_bombBombDisk = DiskSpans(bombBomb);
+    m_synced = false;
+}
+
+void MoveFinder::setSlot(int slot, const Slot &value)
+{
+    Slot &cur = m_slots[size_t(slot)];
+    m_validSlots += int(value.valid) - int(cur.valid);
+    cur = value;
+}
+
+void MoveFinder::evaluate(const TileGrid &board, int slot)
+{
+    const int idx = slot / 2;
+    const int r1 = idx / m_columns, c1 = idx % m_columns;
+    const int r2 = (slot & 1) ? r1 + 1 : r1;
+    const int c2 = (slot & 1) ? c1 : c1 + 1;
+    Slot value;
+    if (board.contains(r2, c2)) evaluateSwap(board, r1, c1, r2, c2, value);
+    setSlot(slot, value);
+}
+
+// 规则与 Match3Engine::playSwap 一致：双道具在 (r2, c2) 触发组合，
+// 道具 + 普通颜色时道具在其落点以对方颜色触发，否则看交换后两端是否形成三消
+void MoveFinder::evaluateSwap(const TileGrid &board, int r1, int c1, int r2, int c2, Slot &out) const
+{
+    const uint8_t a = board.at(r1, c1);
+    const uint8_t b = board.at(r2, c2);
+    if (!tileIsMovable(a) || !tileIsMovable(b)) return;
+
+    const bool aIsProp = tileIsProp(a);
+    const bool bIsProp = tileIsProp(b);
+
+    if (aIsProp && bIsProp) {
+        out.valid = true;
+        const bool aSuper = a == Tile_SuperItem, bSuper = b == Tile_SuperItem;
+        const bool aBomb = a == Tile_Bomb, bBomb = b == Tile_Bomb;
+        if (aSuper && bSuper) {
+            out.propType = Combo_SuperSuperType;
+            out.cleared = m_rows * m_columns;
+        } else if (aSuper || bSuper) {
+            // 超级 + 炸弹/火箭：从中心四邻（搭档已被消耗）中随机选色，全盘该色转化为道具
+            out.propType = (aBomb || bBomb) ? Combo_SuperBombType : Combo_SuperRocketType;
+            out.cleared = 2;
+            static const int neigh[4][2] = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
+            for (const auto &d : neigh) {
+                const int r = r2 + d[0], c = c2 + d[1];
+                if (!board.contains(r, c) || (r == r1 && c == c1)) continue;
+                const uint8_t v = board.at(r, c);
+                if (tileIsColor(v)) out.colors[out.colorCount++] = v;
+            }
+        } else if (aBomb && bBomb) {
+            out.propType = Combo_BombBombType;
+            out.cleared = m_bombBombDisk.count(m_rows, m_columns, r2, c2);
+        } else if (aBomb || bBomb) {
+            out.propType = Combo_BombRocketType;
+            if (rocketTypeOf(aBomb ? b : a) == Rocket_UpDownType) {
+                const int cols = (c2 > 0 ? 1 : 0) + 1 + (c2 + 1 < m_columns ? 1 : 0);
+                out.cleared = cols * m_rows;
+            } else {
+                const int rows = (r2 > 0 ? 1 : 0) + 1 + (r2 + 1 < m_rows ? 1 : 0);
+                out.cleared = rows * m_columns;
+            }
+        } else {
+            out.propType = Combo_RocketRocketType;
+            out.cleared = m_rows + m_columns - 1;
+        }
+        return;
+    }
+
+    if (aIsProp || bIsProp) {
+        out.valid = true;
+        const uint8_t prop = aIsProp ? a : b;
+        const uint8_t other = aIsProp ? b : a;
+        const int row = aIsProp ? r2 : r1;
+        const int col = aIsProp ? c2 : c1;
+        if (prop == Tile_RocketUpDown) {
+            out.propType = Rocket_UpDownType;
+            out.cleared = m_rows;
+        } else if (prop == Tile_RocketLeftRight) {
+            out.propType = Rocket_LeftRightType;
+            out.cleared = m_columns;
+        } else if (prop == Tile_Bomb) {
+            out.propType = BombType;
+            out.cleared = m_bombDisk.count(m_rows, m_columns, row, col);
+        } else {
+            out.propType = SuperItemType;
+            out.cleared = 1;
+            out.colors[0] = other;
+            out.colorCount = 1;
+        }
+        return;
+    }
+
+    if (a == b) return;
+    const SwappedView view = {board, r1, c1, r2, c2};
+    const int cleared = view.clearedAt(r1, c1) + view.clearedAt(r2, c2);
+    if (cleared == 0) return;
+    out.valid = true;
+    out.cleared = cleared;
+}
+
+const std::vector<MoveHint> &MoveFinder::moves(const TileGrid &board)
+{
+    if (m_movesValid) return m_moves;
+
+    // 超级道具相关槽位需要全盘颜色计数
+    int colorCells[TileColorCount] = {0};
+    int total = 0;
+    long long weighted = 0;
+    bool needCounts = false;
+    for (const Slot &s : m_slots) {
+        if (s.valid && (s.propType == SuperItemType || s.propType == Combo_SuperBombType || s.propType == Combo_SuperRocketType)) {
+            needCounts = true;
+            break;
+        }
+    }
+    if (needCounts) {
+        for (int i = 0; i < board.size(); ++i) {
+            const uint8_t v = board.data()[i];
+            if (tileIsColor(v)) { colorCells[v - Tile_Red]++; total++; }
+        }
+        for (int k = 0; k < TileColorCount; ++k) weighted += (long long)colorCells[k] * colorCells[k];
+    }
+
+    m_moves.clear();
+    m_moves.reserve(size_t(m_validSlots));
+    for (int s = 0; s < int(m_slots.size()); ++s) {
+        const Slot &slot = m_slots[size_t(s)];
+        if (!slot.valid) continue;
+        const int idx = s / 2;
+        const int r1 = idx / m_columns, c1 = idx % m_columns;
+        MoveHint hint = {r1, c1, (s & 1) ? r1 + 1 : r1, (s & 1) ? c1 : c1 + 1, slot.cleared, slot.propType};
+        if (slot.propType == SuperItemType && tileIsColor(slot.colors[0])) {
+            hint.cleared += colorCells[slot.colors[0] - Tile_Red];
+        } else if (slot.propType == Combo_SuperBombType || slot.propType == Combo_SuperRocketType) {
+            // 期望值：四邻候选等概率；没有候选时按全盘格子数加权
+            if (slot.colorCount > 0) {
+                int sum = 0;
+                for (int k = 0; k < slot.colorCount; ++k) sum += colorCells[slot.colors[k] - Tile_Red];
+                hint.cleared += (sum + slot.colorCount / 2) / slot.colorCount;
+            } else if (total > 0) {
+                hint.cleared += int((weighted + total / 2) / total);
+            }
+        }
+        m_moves.push_back(hint);
+    }
+    m_movesValid = true;
+    return m_moves;
+}
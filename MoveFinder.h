@@ -0,0 +1,71 @@
+﻿#ifndef MOVEFINDER_H
+#define MOVEFINDER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "TileGrid.h"
+#include "PropEffects.h"
+
+// 一个会产生效果的交换（三消或道具激活）及其直接效果
+struct MoveHint
+{
+    int r1;
+    int c1;
+    int r2;
+    int c2;
+    int cleared;    // 预计直接清除的格子数（含激活的道具自身，不含后续连锁与补位）
+    int propType;   // 0 = 普通三消；否则为将被触发的道具/组合类型（1~4 / 100~105）
+};
+
+// 可走步枚举器：每个格子向右、向下各一个交换槽位，缓存每个槽位的评估结果。
+// 评估只读棋盘、不复制不修改：把交换两端的值代入后就地数连续段。
+// 一个横向交换只依赖所在行和两端所在列，纵向交换只依赖所在列和两端所在行，
+// 因此 update() 只重评版本戳新于上次同步的行/列所覆盖的槽位（与 MatchFinder 同一套版本戳）
+class MoveFinder
+{
+public:
+    // 全盘评估
+    void scan(const TileGrid &board);
+    // 增量评估：只重评受改动行/列影响的槽位，结果与 scan() 完全一致
+    void update(const TileGrid &board);
+
+    // 当前所有可走步（先按行优先的格子顺序，同一格先右后下），需在 scan()/update() 之后调用
+    const std::vector<MoveHint> &moves(const TileGrid &board);
+    bool hasMoves() const { return m_validSlots > 0; }
+    // 炸弹 / 炸弹+炸弹的爆炸半径（与引擎效果表一致）；改变后下次 update() 全盘重评
+    void setBlastRadii(int bomb, int bombBomb);
+    int lastReevaluatedSlots() const { return m_lastReevaluated; }
+
+private:
+    // 槽位评估结果；超级道具相关的清除数依赖全盘颜色计数，在 moves() 中再补上
+    struct Slot
+    {
+        bool valid = false;
+        int propType = 0;
+        int cleared = 0;            // 与颜色计数无关的部分
+        uint8_t colorCount = 0;     // 超级道具可能选中的颜色（0 个表示按全盘颜色加权）
+        uint8_t colors[3] = {0, 0, 0};
+    };
+
+    void reset(const TileGrid &board);
+    void evaluate(const TileGrid &board, int slot);
+    void evaluateSwap(const TileGrid &board, int r1, int c1, int r2, int c2, Slot &out) const;
+    void setSlot(int slot, const Slot &value);
+
+    int m_rows = 0;
+    int m_columns = 0;
+    DiskSpans m_bombDisk{2};
+    DiskSpans m_bombBombDisk{4};
+    bool m_synced = false;
+    uint32_t m_syncedVersion = 0;
+    int m_lastReevaluated = 0;
+    int m_validSlots = 0;
+    std::vector<Slot> m_slots;              // 下标 = 格子下标 * 2 + (0 向右 / 1 向下)
+    std::vector<uint32_t> m_slotStamp;      // 本轮是否已重评（避免行列交叉处重复评估）
+    uint32_t m_stamp = 0;
+    std::vector<MoveHint> m_moves;
+    bool m_movesValid = false;
+};
+
+#endif // MOVEFINDER_H
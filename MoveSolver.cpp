@@ -0,0 +1,197 @@
+﻿#include "MoveSolver.h"
+
+#include <algorithm>
+
+namespace {
+// 叶子处棋面上每个道具的估值：道具迟早会被引爆，按其大致清除量（每格 10 分）打折计入，
+// 使搜索在步数相同时偏向留下道具的交换
+double propValue(uint8_t tile)
+{
+    switch (tile) {
+    case Tile_RocketUpDown:
+    case Tile_RocketLeftRight: return 40.0;
+    case Tile_Bomb:            return 60.0;
+    case Tile_SuperItem:       return 100.0;
+    default:                   return 0.0;
+    }
+}
+
+uint64_t mix(uint64_t z)
+{
+    z += 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// 每隔多少次试走检查一次时间预算
+const long long ClockCheckInterval = 16;
+}
+
+MoveSolver::MoveSolver(const SolverConfig &config)
+{
+    setConfig(config);
+}
+
+void MoveSolver::setConfig(const SolverConfig &config)
+{
+    m_config = config;
+    m_config.maxDepth = std::max(1, m_config.maxDepth);
+    m_config.samples = std::max(1, m_config.samples);
+    m_config.maxBranch = std::max(1, m_config.maxBranch);
+    m_config.tableBits = std::max(4, std::min(24, m_config.tableBits));
+    const size_t entries = size_t(1) << m_config.tableBits;
+    if (m_table.size() != entries) m_table.assign(entries, Entry{0, 0.0f, -1, -1});
+    m_plies.resize(size_t(m_config.maxDepth) + 1);
+}
+
+SolverResult MoveSolver::solve(const Match3Engine &engine)
+{
+    SolverResult result;
+    m_engine = engine;
+    m_engine.setLatencyRecorder(nullptr);   // 试走不计入对局的延迟统计
+    if (m_engine.availableMoves().empty()) return result;
+
+    // 置换表只在一次 solve 内有效：表中的值依赖展开顺序，跨局面复用会让结果随调用历史变化
+    for (Entry &e : m_table) e.depth = -1;
+    for (Ply &p : m_plies) p.snapshot.resize(m_engine.snapshotSize());
+    m_columns = engine.columns();
+    m_nodes = 0;
+    m_tableHits = 0;
+    m_aborted = false;
+    m_deadline = 0;
+    const uint64_t start = LatencyRecorder::now();
+    const uint64_t hash = m_engine.board().hash();
+    const int steps = m_engine.counters().steps;
+    enter(0);
+    Ply &root = m_plies[0];
+
+    int bestSlot = -1;
+    for (int depth = 1; depth <= m_config.maxDepth; ++depth) {
+        orderMoves(root.moves, bestSlot, root.order);
+        double best = 0.0;
+        int bestIndex = -1;
+        for (int idx : root.order) {
+            const double v = tryMove(0, depth, root.moves[size_t(idx)], hash);
+            if (m_aborted) break;
+            if (bestIndex < 0 || v > best) {
+                best = v;
+                bestIndex = idx;
+            }
+        }
+        if (m_aborted) {
+            result.timedOut = true;
+            break;
+        }
+        result.found = true;
+        result.move = root.moves[size_t(bestIndex)];
+        result.value = best;
+        result.depth = depth;
+        bestSlot = slotOf(result.move);
+        if (depth >= steps) break;  // 更深的层已超出剩余步数
+
+        // 第一层总会搜完，预算只约束之后的加深
+        if (m_config.budgetMs > 0) {
+            m_deadline = start + uint64_t(m_config.budgetMs) * 1000000ULL;
+            if (LatencyRecorder::now() >= m_deadline) break;
+        }
+    }
+    result.nodes = m_nodes;
+    result.tableHits = m_tableHits;
+    return result;
+}
+
+void MoveSolver::enter(int ply)
+{
+    Ply &p = m_plies[size_t(ply)];
+    m_engine.saveSnapshot(p.snapshot.data());
+    p.score = m_engine.counters().score;
+    p.moves = m_engine.availableMoves();
+}
+
+double MoveSolver::search(int ply, int depth)
+{
+    const int effective = std::min(depth, m_engine.counters().steps);
+    if (effective <= 0) return leafValue(m_engine.board());
+
+    const uint64_t hash = m_engine.board().hash();
+    Entry &entry = m_table[size_t(hash & (m_table.size() - 1))];
+    int bestSlot = -1;
+    if (entry.depth >= 0 && entry.key == hash) {
+        if (entry.depth >= effective) {
+            ++m_tableHits;
+            return entry.value;
+        }
+        bestSlot = entry.bestSlot;
+    }
+
+    if (!m_engine.hasAvailableMoves()) return leafValue(m_engine.board());
+    enter(ply);
+    Ply &p = m_plies[size_t(ply)];
+    orderMoves(p.moves, bestSlot, p.order);
+    const size_t branch = std::min(p.order.size(), size_t(m_config.maxBranch));
+
+    double best = 0.0;
+    int bestMove = -1;
+    for (size_t k = 0; k < branch; ++k) {
+        const MoveHint &move = p.moves[size_t(p.order[k])];
+        const double v = tryMove(ply, effective, move, hash);
+        if (m_aborted) return 0.0;
+        if (bestMove < 0 || v > best) {
+            best = v;
+            bestMove = slotOf(move);
+        }
+    }
+    entry.key = hash;
+    entry.value = float(best);
+    entry.depth = int16_t(effective);
+    entry.bestSlot = bestMove;
+    return best;
+}
+
+double MoveSolver::tryMove(int ply, int depth, const MoveHint &move, uint64_t hash)
+{
+    const Ply &p = m_plies[size_t(ply)];
+    const uint64_t moveSeed = hash ^ mix((uint64_t(uint32_t(slotOf(move))) << 8) ^ m_config.seed);
+
+    double total = 0.0;
+    for (int s = 0; s < m_config.samples; ++s) {
+        m_engine.restoreSnapshot(p.snapshot.data());
+        m_engine.reseed(mix(moveSeed + uint64_t(s)));
+        m_log.clear();
+        m_engine.playSwap(move.r1, move.c1, move.r2, move.c2, m_log);
+        ++m_nodes;
+        const double gain = double(m_engine.counters().score - p.score);
+        total += gain + (depth > 1 ? search(ply + 1, depth - 1) : leafValue(m_engine.board()));
+        if (m_aborted || outOfTime()) return 0.0;
+    }
+    return total / double(m_config.samples);
+}
+
+void MoveSolver::orderMoves(const std::vector<MoveHint> &moves, int bestSlot, std::vector<int> &order) const
+{
+    // 上一轮的最佳交换在前，其余按预计直接清除数降序；同分保持可走步原顺序，结果与平台无关
+    order.resize(moves.size());
+    for (size_t i = 0; i < moves.size(); ++i) order[i] = int(i);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        const bool aBest = slotOf(moves[size_t(a)]) == bestSlot, bBest = slotOf(moves[size_t(b)]) == bestSlot;
+        if (aBest != bBest) return aBest;
+        if (moves[size_t(a)].cleared != moves[size_t(b)].cleared) return moves[size_t(a)].cleared > moves[size_t(b)].cleared;
+        return a < b;
+    });
+}
+
+double MoveSolver::leafValue(const TileGrid &board) const
+{
+    const uint8_t *cells = board.data();
+    double value = 0.0;
+    for (int i = 0; i < board.size(); ++i) value += propValue(cells[i]);
+    return value;
+}
+
+bool MoveSolver::outOfTime()
+{
+    if (m_deadline == 0 || m_nodes % ClockCheckInterval != 0) return false;
+    m_aborted = LatencyRecorder::now() >= m_deadline;
+    return m_aborted;
+}
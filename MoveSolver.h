@@ -0,0 +1,86 @@
+﻿#ifndef MOVESOLVER_H
+#define MOVESOLVER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Match3Engine.h"
+
+struct SolverConfig
+{
+    int maxDepth = 2;           // 最多向前搜索的交换数
+    int samples = 3;            // 每个交换对补位随机性的采样数
+    int budgetMs = 0;           // 时间预算；0 = 不限时，按 maxDepth 搜完（结果可复现）
+    int maxBranch = 8;          // 根以下的节点只展开排序后的前若干个交换（根节点全部展开）
+    int tableBits = 16;         // 置换表 2^tableBits 项
+    uint64_t seed = 0;          // 采样种子：同一局面 + 同一种子得到同一结果
+};
+
+struct SolverResult
+{
+    bool found = false;
+    MoveHint move = {0, 0, 0, 0, 0, 0};
+    double value = 0.0;         // 期望得分增益（含叶子处棋面道具的估值）
+    int depth = 0;              // 完整搜完的层数
+    long long nodes = 0;        // 试走次数（每次为一次完整的 playSwap 结算）
+    long long tableHits = 0;
+    bool timedOut = false;      // 预算用完时最后一层未搜完，结果取自上一层
+};
+
+// 前瞻搜索：交换为决策节点，交换后的补位为机会节点（expectimax）。
+// 试走在引擎副本上执行与 GameBoard::finalizeSwap 相同的 playSwap，三消、道具生成、组合与连锁
+// 全按真实规则计分；机会节点把副本换成由局面、交换和采样序号派生的种子，取 samples 次的平均，
+// 因此看不到真实的补位结果。迭代加深到 maxDepth 或预算用完，置换表按棋盘哈希（TileGrid::hash）缓存各局面的值
+// 和最佳交换，下一轮加深先试上一轮的最佳交换。整个搜索只用一个引擎副本：每层保存一份快照，
+// 每次试走前从快照恢复（Match3Engine::restoreSnapshot），检测缓存只重扫有差异的行列
+class MoveSolver
+{
+public:
+    explicit MoveSolver(const SolverConfig &config = SolverConfig());
+
+    void setConfig(const SolverConfig &config);
+    const SolverConfig &config() const { return m_config; }
+
+    // 为当前局面选一步；没有可走步时 found 为 false。engine 本身不被修改
+    SolverResult solve(const Match3Engine &engine);
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        float value;
+        int16_t depth;          // 有效深度（不超过剩余步数），-1 为空
+        int32_t bestSlot;       // 最佳交换：格子下标 * 2 + (0 向右 / 1 向下)，-1 为无
+    };
+
+    struct Ply
+    {
+        std::vector<uint8_t> snapshot;  // 本层局面
+        int score = 0;                  // 本层局面的分数
+        std::vector<MoveHint> moves;    // 本层局面的可走步
+        std::vector<int> order;         // 展开顺序（moves 的下标）
+    };
+
+    // 把 m_engine 的当前局面存为第 ply 层
+    void enter(int ply);
+    // 以下两者开始时 m_engine 处于第 ply 层的局面，返回后处于不确定的局面
+    double search(int ply, int depth);
+    double tryMove(int ply, int depth, const MoveHint &move, uint64_t hash);
+    void orderMoves(const std::vector<MoveHint> &moves, int bestSlot, std::vector<int> &order) const;
+    double leafValue(const TileGrid &board) const;
+    int slotOf(const MoveHint &move) const { return (move.r1 * m_columns + move.c1) * 2 + (move.r2 != move.r1 ? 1 : 0); }
+    bool outOfTime();
+
+    SolverConfig m_config;
+    std::vector<Entry> m_table;
+    Match3Engine m_engine;          // 试走用的引擎副本
+    EventLog m_log;
+    std::vector<Ply> m_plies;       // m_plies[0] 为根局面
+    int m_columns = 0;
+    long long m_nodes = 0;
+    long long m_tableHits = 0;
+    uint64_t m_deadline = 0;        // 0 = 不限时
+    bool m_aborted = false;
+};
+
+#endif // MOVESOLVER_H
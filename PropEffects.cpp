@@ -0,0 +1,83 @@
+﻿#include "PropEffects.h"
+#include "Match3Engine.h"
+
+const std::vector<PropEffect> &defaultPropEffects()
+{
+    static const std::vector<PropEffect> effects = {
+        // type                    shape              param  action                 color                consume transpose stat
+        { Rocket_UpDownType,       Shape_Column,      0,     Action_Hit,            Color_None,          true,   false,    Stat_Rocket },
+        { Rocket_LeftRightType,    Shape_Row,         0,     Action_Hit,            Color_None,          true,   false,    Stat_Rocket },
+        { BombType,                Shape_Disk,        2,     Action_Hit,            Color_None,          true,   false,    Stat_Bomb },
+        { SuperItemType,           Shape_ColorSet,    0,     Action_ClearColor,     Color_GivenOrNearby, true,   false,    Stat_SuperItem },
+        { Combo_RocketRocketType,  Shape_Cross,       0,     Action_Hit,            Color_None,          true,   false,    Stat_RocketRocket },
+        { Combo_BombBombType,      Shape_Disk,        4,     Action_Hit,            Color_None,          true,   false,    Stat_BombBomb },
+        { Combo_BombRocketType,    Shape_ColumnBand,  1,     Action_Hit,            Color_None,          true,   true,     Stat_BombRocket },
+        { Combo_SuperBombType,     Shape_ColorSet,    0,     Action_ConvertBombs,   Color_Nearby,        true,   false,    Stat_SuperBomb },
+        { Combo_SuperRocketType,   Shape_ColorSet,    0,     Action_ConvertRockets, Color_Nearby,        true,   false,    Stat_SuperRocket },
+        { Combo_SuperSuperType,    Shape_FullBoard,   0,     Action_Wipe,           Color_None,          false,  false,    Stat_SuperSuper },
+    };
+    return effects;
+}
+
+const PropEffect *findPropEffect(const std::vector<PropEffect> &table, int type)
+{
+    for (const PropEffect &e : table) {
+        if (e.type == type) return &e;
+    }
+    return nullptr;
+}
+
+EffectShape transposedShape(EffectShape shape)
+{
+    switch (shape) {
+    case Shape_Row:        return Shape_Column;
+    case Shape_Column:     return Shape_Row;
+    case Shape_RowBand:    return Shape_ColumnBand;
+    case Shape_ColumnBand: return Shape_RowBand;
+    default:               return shape;
+    }
+}
+
+DiskSpans::DiskSpans(int radius)
+    : radius(radius), halfWidth(size_t(2 * radius + 1), 0)
+{
+    for (int dr = -radius; dr <= radius; ++dr) {
+        int w = 0;
+        while ((w + 1) * (w + 1) + dr * dr <= radius * radius) ++w;
+        halfWidth[size_t(dr + radius)] = w;
+    }
+}
+
+int DiskSpans::count(int rows, int columns, int row, int col) const
+{
+    int total = 0;
+    for (int dr = -radius; dr <= radius; ++dr) {
+        const int r = row + dr;
+        if (r < 0 || r >= rows) continue;
+        const int w = halfWidth[size_t(dr + radius)];
+        const int cFirst = col - w < 0 ? 0 : col - w;
+        const int cLast = col + w >= columns ? columns - 1 : col + w;
+        total += cLast - cFirst + 1;
+    }
+    return total;
+}
+
+void ShapeMasks::reset(int rows, int columns)
+{
+    m_rows = rows;
+    m_columns = columns;
+}
+
+void ShapeMasks::prepare(EffectShape shape, int param)
+{
+    if (shape == Shape_Disk) disk(param);
+}
+
+const DiskSpans &ShapeMasks::disk(int radius)
+{
+    for (const DiskSpans &d : m_disks) {
+        if (d.radius == radius) return d;
+    }
+    m_disks.emplace_back(radius);
+    return m_disks.back();
+}
@@ -0,0 +1,143 @@
+﻿#ifndef PROPEFFECTS_H
+#define PROPEFFECTS_H
+
+#include <cstddef>
+#include <vector>
+
+// 道具/组合效果表：每种激活类型（1~4 / 100~105）对应一个作用区域形状和一种作用方式，
+// Match3Engine::execute 只查表执行同一个清除-连锁内核；新增组合只需在表中加一项
+enum EffectShape
+{
+    Shape_Row,          // 中心所在整行
+    Shape_Column,       // 中心所在整列
+    Shape_Cross,        // 整行 + 整列（先行后列）
+    Shape_Disk,         // 半径 param 的圆形（整数平方距离），按行跨度扫描
+    Shape_RowBand,      // 以中心行为中线、上下各 param 行的横带
+    Shape_ColumnBand,   // 以中心列为中线、左右各 param 列的竖带
+    Shape_ColorSet,     // 全盘选中颜色的格子（依赖棋盘内容，不由 ShapeMasks 产生）
+    Shape_FullBoard     // 全盘
+};
+
+enum EffectAction
+{
+    Action_Hit,             // 区域内普通方块清除，道具排入下一层激活
+    Action_ClearColor,      // 清除全盘选中颜色的普通方块（道具保留）
+    Action_ConvertBombs,    // 选中颜色全部转为炸弹并排入下一层
+    Action_ConvertRockets,  // 选中颜色全部转为随机方向火箭并排入下一层
+    Action_Wipe             // 清空全盘并取消排队中的激活
+};
+
+// 需要选色的效果如何取色
+enum EffectColor
+{
+    Color_None,
+    Color_GivenOrNearby,    // 交换时给定的对方颜色，否则从四邻就近选
+    Color_Nearby            // 总是从四邻就近选
+};
+
+struct PropEffect
+{
+    int type;               // 激活类型
+    EffectShape shape;
+    int param;              // 半径 / 带宽的一半
+    EffectAction action;
+    EffectColor color;
+    bool consumeSelf;       // 先消耗激活格自身（全盘清除时由清除本身带走）
+    bool transposeOnMeta;   // meta 为横向火箭时改用转置形状（炸弹+火箭）
+    int stat;               // 触发时累加的统计下标
+};
+
+// 默认效果表；Match3Engine 持有一份副本，圆形半径等参数可按局调整
+const std::vector<PropEffect> &defaultPropEffects();
+// 查表；未知类型返回 nullptr
+const PropEffect *findPropEffect(const std::vector<PropEffect> &table, int type);
+EffectShape transposedShape(EffectShape shape);
+
+// 半径 radius 的圆形（整数平方距离）按行的跨度：halfWidth[dr + radius] 为相对中心第 dr 行
+// 左右各覆盖的列数。与棋盘尺寸无关，裁剪只是把 [col - w, col + w] 与 [0, columns) 求交，
+// 因此一次引爆是逐行的直接扫描，没有包围盒内的逐格距离判断，也没有任何分配
+struct DiskSpans
+{
+    explicit DiskSpans(int radius = 0);
+
+    // 以 (row, col) 为中心、裁剪到棋盘内的格子数（含中心）
+    int count(int rows, int columns, int row, int col) const;
+    // 按行优先顺序对裁剪后的每个格子（不含中心）调用 fn(r, c)
+    template <typename Fn>
+    void forEach(int rows, int columns, int row, int col, Fn &&fn) const
+    {
+        const int rFirst = row - radius < 0 ? 0 : row - radius;
+        const int rLast = row + radius >= rows ? rows - 1 : row + radius;
+        for (int r = rFirst; r <= rLast; ++r) {
+            const int w = halfWidth[size_t(r - row + radius)];
+            const int cFirst = col - w < 0 ? 0 : col - w;
+            const int cLast = col + w >= columns ? columns - 1 : col + w;
+            for (int c = cFirst; c <= cLast; ++c) {
+                if (r != row || c != col) fn(r, c);
+            }
+        }
+    }
+
+    int radius;
+    std::vector<int> halfWidth;
+};
+
+// 道具作用区域：行、列、十字与横/竖带本身就是整行/整列的跨度，圆形为 DiskSpans，
+// 都在激活时按中心裁剪后直接扫描，不保存逐中心的下标表，占用与棋盘尺寸无关，引擎副本也只复制几个圆形跨度。
+// 区域不含中心格，顺序固定以保证结算可复现：行、横带与圆形为行优先，列与竖带为列优先，十字先行后列
+class ShapeMasks
+{
+public:
+    void reset(int rows, int columns);
+    // 半径 radius 的圆形跨度，首次使用时构建
+    const DiskSpans &disk(int radius);
+    // 提前建好 (shape, param) 所需的跨度，使之后的激活不再分配
+    void prepare(EffectShape shape, int param);
+
+    // 对以 (row, col) 为中心、裁剪到棋盘内的区域中每个格子调用 fn(r, c)；
+    // ColorSet / FullBoard 依赖棋盘内容，不在此处产生格子
+    template <typename Fn>
+    void forEach(EffectShape shape, int param, int row, int col, Fn &&fn)
+    {
+        switch (shape) {
+        case Shape_Row:
+            for (int c = 0; c < m_columns; ++c) if (c != col) fn(row, c);
+            break;
+        case Shape_Column:
+            for (int r = 0; r < m_rows; ++r) if (r != row) fn(r, col);
+            break;
+        case Shape_Cross:
+            for (int c = 0; c < m_columns; ++c) if (c != col) fn(row, c);
+            for (int r = 0; r < m_rows; ++r) if (r != row) fn(r, col);
+            break;
+        case Shape_Disk:
+            disk(param).forEach(m_rows, m_columns, row, col, fn);
+            break;
+        case Shape_RowBand: {
+            const int rFirst = row - param < 0 ? 0 : row - param;
+            const int rLast = row + param >= m_rows ? m_rows - 1 : row + param;
+            for (int r = rFirst; r <= rLast; ++r) {
+                for (int c = 0; c < m_columns; ++c) if (r != row || c != col) fn(r, c);
+            }
+            break;
+        }
+        case Shape_ColumnBand: {
+            const int cFirst = col - param < 0 ? 0 : col - param;
+            const int cLast = col + param >= m_columns ? m_columns - 1 : col + param;
+            for (int c = cFirst; c <= cLast; ++c) {
+                for (int r = 0; r < m_rows; ++r) if (r != row || c != col) fn(r, c);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+private:
+    int m_rows = 0;
+    int m_columns = 0;
+    std::vector<DiskSpans> m_disks;
+};
+
+#endif // PROPEFFECTS_H
@@ -0,0 +1,146 @@
+﻿#include "RunScanner.h"
+#include "TileGrid.h"
+
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RUNSCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(RUNSCANNER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define RUNSCANNER_TARGET(isa) __attribute__((target(isa)))
+#else
+#define RUNSCANNER_TARGET(isa)
+#endif
+
+namespace RunScanner
+{
+namespace {
+typedef void (*PairFn)(const uint8_t *a, const uint8_t *b, int n, int from, uint64_t *bits);
+
+// 逐格比较，处理 [from, n)，也用作向量版本的尾部
+void pairScalar(const uint8_t *a, const uint8_t *b, int n, int from, uint64_t *bits)
+{
+    for (int i = from; i < n; ++i) {
+        if (a[i] == b[i] && tileIsColor(a[i])) bits[i >> 6] |= uint64_t(1) << (i & 63);
+    }
+}
+
+#ifdef RUNSCANNER_X86
+// 常规颜色 Tile_Red..Tile_Brown 的字节掩码：clamp(x) == x
+RUNSCANNER_TARGET("sse2")
+inline __m128i colorMask128(__m128i x)
+{
+    const __m128i lo = _mm_set1_epi8(char(Tile_Red));
+    const __m128i hi = _mm_set1_epi8(char(Tile_Brown));
+    return _mm_cmpeq_epi8(_mm_min_epu8(_mm_max_epu8(x, lo), hi), x);
+}
+
+RUNSCANNER_TARGET("sse2")
+void pairSse2(const uint8_t *a, const uint8_t *b, int n, int from, uint64_t *bits)
+{
+    int i = from;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        const uint32_t m = uint32_t(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(x, y), colorMask128(x))));
+        bits[i >> 6] |= uint64_t(m) << (i & 63);
+    }
+    pairScalar(a, b, n, i, bits);
+}
+
+RUNSCANNER_TARGET("avx2")
+void pairAvx2(const uint8_t *a, const uint8_t *b, int n, int from, uint64_t *bits)
+{
+    const __m256i lo = _mm256_set1_epi8(char(Tile_Red));
+    const __m256i hi = _mm256_set1_epi8(char(Tile_Brown));
+    int i = from;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        const __m256i color = _mm256_cmpeq_epi8(_mm256_min_epu8(_mm256_max_epu8(x, lo), hi), x);
+        const uint32_t m = uint32_t(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(x, y), color)));
+        bits[i >> 6] |= uint64_t(m) << (i & 63);
+    }
+    // i 是 32 的倍数，剩余不足 32 格交给 SSE2 / 逐格处理
+    pairSse2(a, b, n, i, bits);
+}
+
+Isa detectIsa()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return Isa_SSE2;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return Isa_SSE2;
+    if ((_xgetbv(0) & 0x6) != 0x6) return Isa_SSE2;   // 操作系统需保存 YMM 寄存器
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) ? Isa_AVX2 : Isa_SSE2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return Isa_AVX2;
+    if (__builtin_cpu_supports("sse2")) return Isa_SSE2;
+    return Isa_Scalar;
+#endif
+}
+#else
+Isa detectIsa() { return Isa_Scalar; }
+#endif
+
+std::atomic<int> s_isa(-1);
+
+PairFn pairFn(Isa isa)
+{
+#ifdef RUNSCANNER_X86
+    if (isa == Isa_AVX2) return pairAvx2;
+    if (isa == Isa_SSE2) return pairSse2;
+#else
+    (void)isa;
+#endif
+    return pairScalar;
+}
+}
+
+Isa activeIsa()
+{
+    int isa = s_isa.load(std::memory_order_relaxed);
+    if (isa < 0) {
+        isa = detectIsa();
+        s_isa.store(isa, std::memory_order_relaxed);
+    }
+    return Isa(isa);
+}
+
+const char *isaName(Isa isa)
+{
+    switch (isa) {
+    case Isa_AVX2: return "AVX2";
+    case Isa_SSE2: return "SSE2";
+    default:       return "Scalar";
+    }
+}
+
+void overrideIsa(Isa isa)
+{
+    const Isa best = detectIsa();
+    s_isa.store(isa > best ? best : isa, std::memory_order_relaxed);
+}
+
+void pairEqualBits(const uint8_t *a, const uint8_t *b, int n, uint64_t *bits)
+{
+    if (n <= 0) return;
+    std::memset(bits, 0, size_t(wordsFor(n)) * sizeof(uint64_t));
+    pairFn(activeIsa())(a, b, n, 0, bits);
+}
+
+void adjacentEqualBits(const uint8_t *p, int n, uint64_t *bits)
+{
+    // 与错开一格的自身比较：p[i] vs p[i+1]，共 n-1 个位置
+    pairEqualBits(p, p + 1, n - 1, bits);
+}
+}
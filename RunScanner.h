@@ -0,0 +1,73 @@
+﻿#ifndef RUNSCANNER_H
+#define RUNSCANNER_H
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// 向量化的相邻格比较：一条指令比较 16（SSE2）或 32（AVX2）个字节编码的格子，
+// 输出“与下一格同色”的位图，连续段边界即位图中的 0。
+// 运行时检测 CPU 支持的最宽指令集，非 x86 平台退回逐格比较
+namespace RunScanner
+{
+enum Isa
+{
+    Isa_Scalar,
+    Isa_SSE2,
+    Isa_AVX2
+};
+
+// 当前进程实际使用的指令集（首次调用时检测并缓存）
+Isa activeIsa();
+const char *isaName(Isa isa);
+// 强制指定指令集（用于对比测试），超出 CPU 能力时按能力截断
+void overrideIsa(Isa isa);
+
+// 最低位 1 的下标，x 必须非 0
+inline int lowestBit(uint64_t x)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return int(idx);
+#elif defined(_MSC_VER)
+    unsigned long idx;
+    if (_BitScanForward(&idx, static_cast<unsigned long>(x))) return int(idx);
+    _BitScanForward(&idx, static_cast<unsigned long>(x >> 32));
+    return int(idx) + 32;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// 最高位 1 的下标，x 必须非 0
+inline int highestBit(uint64_t x)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long idx;
+    _BitScanReverse64(&idx, x);
+    return int(idx);
+#elif defined(_MSC_VER)
+    unsigned long idx;
+    if (_BitScanReverse(&idx, static_cast<unsigned long>(x >> 32))) return int(idx) + 32;
+    _BitScanReverse(&idx, static_cast<unsigned long>(x));
+    return int(idx);
+#else
+    return 63 - __builtin_clzll(x);
+#endif
+}
+
+// 位图所需 64 位字数
+inline int wordsFor(int bits) { return (bits + 63) / 64; }
+
+// 同一行内相邻比较：第 i 位 = (p[i] == p[i+1] 且 p[i] 为常规颜色)，i ∈ [0, n-1)
+// bits 需至少 wordsFor(n) 个字，函数会先清零
+void adjacentEqualBits(const uint8_t *p, int n, uint64_t *bits);
+
+// 上下两行逐列比较：第 c 位 = (a[c] == b[c] 且 a[c] 为常规颜色)，c ∈ [0, n)
+void pairEqualBits(const uint8_t *a, const uint8_t *b, int n, uint64_t *bits);
+}
+
+#endif // RUNSCANNER_H
@@ -0,0 +1,181 @@
+﻿#include "Simulator.h"
+#include "AllocCounter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace {
+SwapMove toSwap(const MoveHint &m)
+{
+    return {m.r1, m.c1, m.r2, m.c2};
+}
+
+// 随机选择一个有效交换
+class RandomPolicy : public MovePolicy
+{
+public:
+    const char *name() const override { return "random"; }
+    bool chooseMove(const Match3Engine &engine, GameRng &rng, SwapMove &move) override {
+        const std::vector<MoveHint> &moves = engine.availableMoves();
+        if (moves.empty()) return false;
+        move = toSwap(moves[size_t(rng.bounded(int(moves.size())))]);
+        return true;
+    }
+};
+
+// 一步试走：在引擎副本上执行每个候选交换，取得分最高者（同分随机）。
+// 副本换用新种子，试走看不到真实的补位结果
+class GreedyPolicy : public MovePolicy
+{
+public:
+    const char *name() const override { return "greedy"; }
+    bool chooseMove(const Match3Engine &engine, GameRng &rng, SwapMove &move) override {
+        const std::vector<MoveHint> &moves = engine.availableMoves();
+        if (moves.empty()) return false;
+        int best = -1;
+        int ties = 0;
+        for (const MoveHint &m : moves) {
+            Match3Engine trial = engine;
+            trial.reseed((uint64_t(rng.next()) << 32) | rng.next());
+            m_log.clear();
+            trial.playSwap(m.r1, m.c1, m.r2, m.c2, m_log);
+            const int gain = trial.counters().score - engine.counters().score;
+            if (gain > best) {
+                best = gain;
+                ties = 1;
+                move = toSwap(m);
+            } else if (gain == best && rng.bounded(++ties) == 0) {
+                move = toSwap(m);   // 水塘抽样，等概率挑选同分走法
+            }
+        }
+        return true;
+    }
+
+private:
+    EventLog m_log;
+};
+
+// 前瞻搜索：交换后的补位按采样取期望，迭代加深到配置的层数
+class ExpectimaxPolicy : public MovePolicy
+{
+public:
+    explicit ExpectimaxPolicy(const SolverConfig &config) : m_solver(config) {}
+    const char *name() const override { return "expectimax"; }
+    bool chooseMove(const Match3Engine &engine, GameRng &, SwapMove &move) override {
+        const SolverResult result = m_solver.solve(engine);
+        if (!result.found) return false;
+        move = toSwap(result.move);
+        return true;
+    }
+
+private:
+    MoveSolver m_solver;
+};
+
+// 每局预先备好的事件槽位数：绝大多数步的事件数（交换 + 每轮三消/下落 + 激活）都在此之内
+const size_t LogReserveEvents = 64;
+
+// 由总种子和局序号派生每局种子（与线程划分无关）
+uint64_t gameSeed(uint64_t seed, int gameIndex)
+{
+    return seed ^ (uint64_t(gameIndex) * 0x9E3779B97F4A7C15ULL);
+}
+}
+
+std::unique_ptr<MovePolicy> makePolicy(const std::string &name, const SolverConfig &solver)
+{
+    if (name == "random") return std::unique_ptr<MovePolicy>(new RandomPolicy);
+    if (name == "greedy") return std::unique_ptr<MovePolicy>(new GreedyPolicy);
+    if (name == "expectimax") return std::unique_ptr<MovePolicy>(new ExpectimaxPolicy(solver));
+    return std::unique_ptr<MovePolicy>();
+}
+
+std::vector<std::string> policyNames()
+{
+    return {"random", "greedy", "expectimax"};
+}
+
+GameResult simulateGame(const SimConfig &config, int gameIndex, MovePolicy &policy)
+{
+    const uint64_t seed = gameSeed(config.seed, gameIndex);
+    Match3Engine engine(config.rows, config.columns, config.backend, seed);
+    GameRng policyRng(~seed);
+    engine.newBoard();
+    engine.resetCounters(config.steps);
+
+    GameResult result;
+    EventLog log;
+    log.reserve(LogReserveEvents, engine.board());
+    SwapMove move;
+    while (engine.counters().steps > 0) {
+        if (!policy.chooseMove(engine, policyRng, move)) {
+            if (result.shuffles >= config.maxShuffles) break;
+            engine.shuffle();
+            result.shuffles++;
+            continue;
+        }
+        log.clear();
+        const uint64_t allocsBefore = AllocCounter::count();
+        engine.playSwap(move.r1, move.c1, move.r2, move.c2, log);
+        if (result.moves >= config.warmupMoves) {
+            result.steadyMoves++;
+            result.steadyAllocations += (long long)(AllocCounter::count() - allocsBefore);
+        }
+        result.moves++;
+
+        // 连锁深度：本步内三消轮数（combo 在每轮三消时递增）
+        int cascade = 0;
+        for (const EngineEvent &ev : log) {
+            if (ev.kind == EngineEvent::Event_Match) cascade = std::max(cascade, ev.counters.combo);
+            else if (ev.kind == EngineEvent::Event_Shuffle) result.shuffles++;
+        }
+        result.cascadeRounds += cascade;
+        result.maxCascade = std::max(result.maxCascade, cascade);
+    }
+
+    const EngineCounters &counters = engine.counters();
+    result.score = counters.score;
+    std::copy(counters.stats, counters.stats + StatCount, result.stats);
+    return result;
+}
+
+SimSummary runSimulation(const SimConfig &config)
+{
+    int threads = config.threads > 0 ? config.threads : int(std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(threads, std::max(1, config.games)));
+
+    std::vector<GameResult> results(size_t(std::max(0, config.games)));
+    const auto start = std::chrono::steady_clock::now();
+
+    // 第 t 个线程处理局序号 t, t+threads, ...：各线程只写自己负责的结果槽位，无锁无共享
+    std::vector<std::thread> pool;
+    pool.reserve(size_t(threads));
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&config, &results, t, threads]() {
+            std::unique_ptr<MovePolicy> policy = makePolicy(config.policy, config.solver);
+            if (!policy) return;
+            for (int i = t; i < config.games; i += threads) {
+                results[size_t(i)] = simulateGame(config, i, *policy);
+            }
+        });
+    }
+    for (std::thread &th : pool) th.join();
+
+    SimSummary summary;
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    summary.games = config.games;
+    summary.threads = threads;
+    summary.scores.reserve(results.size());
+    for (const GameResult &r : results) {
+        summary.scores.push_back(r.score);
+        summary.totalMoves += r.moves;
+        summary.totalShuffles += r.shuffles;
+        summary.totalCascadeRounds += r.cascadeRounds;
+        summary.maxCascade = std::max(summary.maxCascade, r.maxCascade);
+        summary.steadyMoves += r.steadyMoves;
+        summary.steadyAllocations += r.steadyAllocations;
+        for (int k = 0; k < StatCount; ++k) summary.stats[k] += r.stats[k];
+    }
+    return summary;
+}
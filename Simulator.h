@@ -0,0 +1,90 @@
+﻿#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GameRng.h"
+#include "Match3Engine.h"
+#include "MoveSolver.h"
+
+// 一次候选交换
+struct SwapMove
+{
+    int r1;
+    int c1;
+    int r2;
+    int c2;
+};
+
+// 走法策略：给定当前局面选择下一步。每个工作线程持有自己的策略实例，实现无需线程安全
+class MovePolicy
+{
+public:
+    virtual ~MovePolicy() {}
+    virtual const char *name() const = 0;
+    // 返回 false 表示没有可走的交换（调用方会打乱棋盘）
+    virtual bool chooseMove(const Match3Engine &engine, GameRng &rng, SwapMove &move) = 0;
+};
+
+// 按名称创建策略："random"（随机有效交换）、"greedy"（一步试走取得分最高者）、
+// "expectimax"（按 solver 配置前瞻搜索），未知名称返回空
+std::unique_ptr<MovePolicy> makePolicy(const std::string &name, const SolverConfig &solver = SolverConfig());
+std::vector<std::string> policyNames();
+
+struct SimConfig
+{
+    int games = 1000;
+    int threads = 0;            // 0 = 硬件线程数
+    uint64_t seed = 1;          // 第 i 局的种子由 seed 与 i 派生，结果与线程数无关
+    int rows = 8;
+    int columns = 8;
+    int steps = 25;             // 每局步数（对应 GameBoard::m_init_step）
+    int maxShuffles = 20;       // 无路可走时最多打乱次数，超过即提前结束该局
+    int warmupMoves = 1;        // 每局前几步用于检测器缓存热身，不计入稳态分配统计
+    long long maxAllocations = -1; // 稳态分配次数上限，超出时模拟器以非零码退出；-1 = 不检查
+    std::string policy = "random";
+    SolverConfig solver;        // expectimax 策略的搜索参数（默认不限时，结果可复现）
+    MatchFinder::Backend backend = MatchFinder::Backend_Scalar;
+};
+
+// 单局结果
+struct GameResult
+{
+    int score = 0;
+    int moves = 0;              // 实际走出的有效交换数
+    int shuffles = 0;           // 无步可走时的重排次数（引擎自动重排 + 策略找不到走法）
+    int maxCascade = 0;         // 单步内最长连锁（连续三消轮数）
+    long long cascadeRounds = 0; // 各步连锁轮数之和
+    int steadyMoves = 0;        // 热身之后的步数
+    long long steadyAllocations = 0; // 热身之后 playSwap 内的堆分配次数（链接 AllocCounter 时统计）
+    int stats[StatCount] = {0};
+};
+
+// 汇总结果
+struct SimSummary
+{
+    int games = 0;
+    int threads = 0;
+    double seconds = 0.0;
+    long long totalMoves = 0;
+    long long totalShuffles = 0;
+    long long totalCascadeRounds = 0;
+    int maxCascade = 0;
+    long long steadyMoves = 0;
+    long long steadyAllocations = 0;
+    long long stats[StatCount] = {0};
+    std::vector<int> scores;    // 按局序号排列
+
+    double gamesPerSecond() const { return seconds > 0.0 ? games / seconds : 0.0; }
+};
+
+// 单局模拟（不依赖任何共享状态）
+GameResult simulateGame(const SimConfig &config, int gameIndex, MovePolicy &policy);
+
+// 把 games 局均分给线程池并行模拟；每个线程独立的引擎、随机数和策略实例
+SimSummary runSimulation(const SimConfig &config);
+
+#endif // SIMULATOR_H
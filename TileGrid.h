@@ -0,0 +1,163 @@
+﻿#ifndef TILEGRID_H
+#define TILEGRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// 道具类型编号（PropTypedef.type 与 propBatch 各项的 type 共用）
+#define Rocket_UpDownType    1
+#define Rocket_LeftRightType 2
+#define BombType             3
+#define SuperItemType        4
+
+// 新增组合道具类型，用于在 propBatch 中编码复合激活（QML 识别并播放合成动画）
+#define Combo_RocketRocketType 100
+#define Combo_BombBombType     101
+#define Combo_BombRocketType   102
+#define Combo_SuperBombType    103 // 超级道具 + 炸弹
+#define Combo_SuperRocketType  104 // 超级道具 + 火箭
+#define Combo_SuperSuperType   105 // 超级道具 + 超级道具（两次全图涟漪清除）
+
+// 紧凑格子编码：每格一个字节，0 为空，1~6 为常规颜色，之后为四种道具
+// 颜色编码顺序与 m_stats 的 0-5 统计下标一一对应（编码 - Tile_Red）
+enum TileCode : uint8_t
+{
+    Tile_Empty = 0,
+
+    Tile_Red,
+    Tile_Green,
+    Tile_Blue,
+    Tile_Yellow,
+    Tile_Purple,
+    Tile_Brown,
+
+    Tile_RocketUpDown,     // 对应 Rocket_UpDown    "Rocket_1"
+    Tile_RocketLeftRight,  // 对应 Rocket_LeftRight "Rocket_2"
+    Tile_Bomb,             // 对应 Bomb             "Bomb"
+    Tile_SuperItem,        // 对应 SuperItem        "SuperItem"
+
+    Tile_CodeCount
+};
+
+static const int TileColorCount = Tile_Brown - Tile_Red + 1;
+
+inline bool tileIsColor(uint8_t t)   { return t >= Tile_Red && t <= Tile_Brown; }
+inline bool tileIsProp(uint8_t t)    { return t >= Tile_RocketUpDown && t <= Tile_SuperItem; }
+inline bool tileIsMovable(uint8_t t) { return t != Tile_Empty && t < Tile_CodeCount; }
+inline bool tileIsRocket(uint8_t t)  { return t == Tile_RocketUpDown || t == Tile_RocketLeftRight; }
+
+// 扁平连续存储的棋盘：按行优先排列，下标 = row * columns + col
+// 所有写入都经过 set()，并给所在行/列打上递增的版本戳，
+// 增量检测器只需比较版本戳即可知道自上次同步以来哪些行列被改动过；
+// set() 同时增量维护 64 位 Zobrist 哈希，hash() 为 O(1)
+class TileGrid
+{
+public:
+    TileGrid() = default;
+    TileGrid(int rows, int columns) { resize(rows, columns); }
+
+    void resize(int rows, int columns) {
+        m_rows = rows;
+        m_columns = columns;
+        m_cells.assign(size_t(rows) * size_t(columns), Tile_Empty);
+        m_rowVersion.assign(size_t(rows), 0);
+        m_colVersion.assign(size_t(columns), 0);
+        m_hash = shapeKey(rows, columns);
+        touchAll();
+    }
+    void fill(uint8_t code) {
+        m_cells.assign(m_cells.size(), code);
+        m_hash = shapeKey(m_rows, m_columns);
+        for (int i = 0; i < size(); ++i) m_hash ^= zobristKey(i, code);
+        touchAll();
+    }
+
+    int rows() const { return m_rows; }
+    int columns() const { return m_columns; }
+    int size() const { return int(m_cells.size()); }
+    bool contains(int row, int col) const { return row >= 0 && row < m_rows && col >= 0 && col < m_columns; }
+    int index(int row, int col) const { return row * m_columns + col; }
+
+    uint8_t at(int row, int col) const { return m_cells[size_t(row * m_columns + col)]; }
+    const uint8_t *rowData(int row) const { return m_cells.data() + size_t(row) * size_t(m_columns); }
+    const uint8_t *data() const { return m_cells.data(); }
+
+    void set(int row, int col, uint8_t code) {
+        uint8_t &cell = m_cells[size_t(row * m_columns + col)];
+        if (cell == code) return;
+        m_hash ^= zobristKey(row * m_columns + col, cell) ^ zobristKey(row * m_columns + col, code);
+        cell = code;
+        ++m_version;
+        m_rowVersion[size_t(row)] = m_version;
+        m_colVersion[size_t(col)] = m_version;
+    }
+    // 整盘写入（快照恢复）：cells 为 size() 个编码，hash 为其哈希（由保存方给出，免去重算）。
+    // 逐行比较，只拷贝并标记有差异的行与列，增量检测器随后只重扫这些行列
+    void assign(const uint8_t *cells, uint64_t hash) {
+        bool changed = false;
+        for (int r = 0; r < m_rows; ++r) {
+            uint8_t *row = m_cells.data() + size_t(r) * size_t(m_columns);
+            const uint8_t *src = cells + size_t(r) * size_t(m_columns);
+            if (std::memcmp(row, src, size_t(m_columns)) == 0) continue;
+            if (!changed) {
+                ++m_version;
+                changed = true;
+            }
+            m_rowVersion[size_t(r)] = m_version;
+            for (int c = 0; c < m_columns; ++c) {
+                if (row[c] != src[c]) m_colVersion[size_t(c)] = m_version;
+            }
+            std::memcpy(row, src, size_t(m_columns));
+        }
+        m_hash = hash;
+    }
+    void swap(int r1, int c1, int r2, int c2) {
+        const uint8_t a = at(r1, c1);
+        set(r1, c1, at(r2, c2));
+        set(r2, c2, a);
+    }
+
+    // 版本戳：每次实际改变格子内容都会递增
+    uint32_t version() const { return m_version; }
+    uint32_t rowVersion(int row) const { return m_rowVersion[size_t(row)]; }
+    uint32_t colVersion(int col) const { return m_colVersion[size_t(col)]; }
+
+    // 棋盘尺寸与内容的 Zobrist 哈希：内容相同的棋盘哈希相同，与写入顺序和版本戳无关
+    uint64_t hash() const { return m_hash; }
+    // 下标 index 处为 code 时参与异或的键：由 (下标, 编码) 混合得到，不需要随尺寸预生成随机表；空格为 0
+    static uint64_t zobristKey(int index, uint8_t code) {
+        return code == Tile_Empty ? 0 : mix(uint64_t(uint32_t(index)) * Tile_CodeCount + code);
+    }
+
+    bool operator==(const TileGrid &o) const { return m_rows == o.m_rows && m_columns == o.m_columns && m_cells == o.m_cells; }
+    bool operator!=(const TileGrid &o) const { return !(*this == o); }
+
+private:
+    // splitmix64 的输出混合
+    static uint64_t mix(uint64_t z) {
+        z += 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    static uint64_t shapeKey(int rows, int columns) {
+        return mix((uint64_t(uint32_t(rows)) << 32) | uint32_t(columns));
+    }
+    void touchAll() {
+        ++m_version;
+        m_rowVersion.assign(m_rowVersion.size(), m_version);
+        m_colVersion.assign(m_colVersion.size(), m_version);
+    }
+
+    int m_rows = 0;
+    int m_columns = 0;
+    std::vector<uint8_t> m_cells;
+    uint32_t m_version = 0;
+    uint64_t m_hash = 0;
+    std::vector<uint32_t> m_rowVersion;
+    std::vector<uint32_t> m_colVersion;
+};
+
+#endif // TILEGRID_H
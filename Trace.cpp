@@ -0,0 +1,133 @@
+﻿#include "Trace.h"
+#include "TileGrid.h"
+
+#include <chrono>
+#include <cstdio>
+
+namespace Trace
+{
+namespace detail {
+std::atomic<unsigned> s_categories(Cat_All);
+std::atomic<int> s_level(Level_Info);
+}
+
+namespace {
+const int Capacity = 4096;  // 2 的幂
+
+// 每个槽位带序号：写入期间为 0，写完为 (全局序号 + 1)，读者据此判断是否读到完整记录
+struct Slot
+{
+    std::atomic<uint64_t> ready;
+    Record record;
+};
+
+Slot s_ring[Capacity];
+std::atomic<uint64_t> s_head(0);
+uint64_t s_tail = 0;                    // 仅消费者访问
+std::atomic<uint64_t> s_dropped(0);
+std::atomic<Sink> s_sink(nullptr);
+
+const char *const CategoryNames[] = { "swap", "match", "prop", "drop", "board", "replay" };
+const char *const LevelNames[] = { "D", "I", "W" };
+
+const char *categoryName(uint8_t category)
+{
+    for (int i = 0; i < 6; ++i) {
+        if (category == (1u << i)) return CategoryNames[i];
+    }
+    return "?";
+}
+
+uint64_t nowNanos()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+}
+
+void setCategories(unsigned mask) { detail::s_categories.store(mask, std::memory_order_relaxed); }
+void setLevel(Level level) { detail::s_level.store(int(level), std::memory_order_relaxed); }
+void setSink(Sink sink) { s_sink.store(sink, std::memory_order_release); }
+bool hasSink() { return s_sink.load(std::memory_order_relaxed) != nullptr; }
+
+void record(Category category, Level level, const char *format, int a0, int a1, int a2, int a3)
+{
+    const uint64_t seq = s_head.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = s_ring[seq & (Capacity - 1)];
+    slot.ready.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.record.nanos = nowNanos();
+    slot.record.format = format;
+    slot.record.args[0] = a0;
+    slot.record.args[1] = a1;
+    slot.record.args[2] = a2;
+    slot.record.args[3] = a3;
+    slot.record.category = uint8_t(category);
+    slot.record.level = uint8_t(level);
+    slot.ready.store(seq + 1, std::memory_order_release);
+}
+
+int drain()
+{
+    const Sink sink = s_sink.load(std::memory_order_acquire);
+    const uint64_t head = s_head.load(std::memory_order_acquire);
+    if (head - s_tail > uint64_t(Capacity)) {
+        // 消费太慢，最旧的记录已被覆盖
+        s_dropped.fetch_add(head - Capacity - s_tail, std::memory_order_relaxed);
+        s_tail = head - Capacity;
+    }
+
+    int emitted = 0;
+    char text[256];
+    char line[320];
+    for (; s_tail < head; ++s_tail) {
+        Slot &slot = s_ring[s_tail & (Capacity - 1)];
+        // 序号锁式读取：前后两次序号一致才说明读到的是完整且未被覆盖的记录
+        const uint64_t before = slot.ready.load(std::memory_order_acquire);
+        if (before != s_tail + 1) {
+            s_dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        const Record r = slot.record;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.ready.load(std::memory_order_relaxed) != before) {
+            s_dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (!sink) continue;
+        std::snprintf(text, sizeof(text), r.format, r.args[0], r.args[1], r.args[2], r.args[3]);
+        std::snprintf(line, sizeof(line), "[%llu.%06llu %s %s] %s",
+                      static_cast<unsigned long long>(r.nanos / 1000000000ULL),
+                      static_cast<unsigned long long>((r.nanos / 1000ULL) % 1000000ULL),
+                      LevelNames[r.level < 3 ? r.level : 0], categoryName(r.category), text);
+        sink(line);
+        emitted++;
+    }
+    return emitted;
+}
+
+uint64_t droppedRecords()
+{
+    return s_dropped.load(std::memory_order_relaxed);
+}
+
+void dumpBoard(Category category, const char *label, const TileGrid &board)
+{
+    const Sink sink = s_sink.load(std::memory_order_acquire);
+    if (!sink) return;
+    // 每格一个字符：. 为空，1~6 为颜色，| - 为竖/横火箭，B 为炸弹，S 为超级道具
+    static const char Glyphs[] = ".123456|-BS";
+    char line[320];
+    std::snprintf(line, sizeof(line), "[%s] %s (%dx%d)", categoryName(uint8_t(category)), label, board.rows(), board.columns());
+    sink(line);
+    for (int r = 0; r < board.rows(); ++r) {
+        int n = std::snprintf(line, sizeof(line), "  %3d ", r);
+        for (int c = 0; c < board.columns() && n < int(sizeof(line)) - 1; ++c) {
+            const uint8_t v = board.at(r, c);
+            line[n++] = v < Tile_CodeCount ? Glyphs[v] : '?';
+        }
+        line[n] = '\0';
+        sink(line);
+    }
+}
+}
@@ -0,0 +1,84 @@
+﻿#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+
+class TileGrid;
+
+// 热路径追踪：按类别 + 级别过滤，记录只写入无锁环形缓冲（格式串指针 + 最多 4 个整数），
+// 不在调用点格式化；由 drain() 在空闲时统一格式化后交给 sink。
+// 未定义 MATCH3_TRACE 时所有宏展开为空语句，参数不求值
+namespace Trace
+{
+enum Category
+{
+    Cat_Swap   = 1 << 0,    // 交换 / 回滚
+    Cat_Match  = 1 << 1,    // 三消与道具生成
+    Cat_Prop   = 1 << 2,    // 道具 / 组合激活
+    Cat_Drop   = 1 << 3,    // 下落与补位
+    Cat_Board  = 1 << 4,    // 生成 / 打乱 / 修复
+    Cat_Replay = 1 << 5,    // GameBoard 事件回放
+    Cat_All    = 0xFF
+};
+
+enum Level
+{
+    Level_Debug,
+    Level_Info,
+    Level_Warn
+};
+
+// 格式化后的一行输出；sink 可能在任意调用 drain()/dumpBoard() 的线程上被调用
+typedef void (*Sink)(const char *line);
+
+struct Record
+{
+    uint64_t nanos;         // 单调时钟
+    const char *format;     // 必须是字符串字面量（只保存指针）
+    int args[4];
+    uint8_t category;
+    uint8_t level;
+};
+
+// 运行时过滤（默认全部类别、Info 及以上）
+void setCategories(unsigned mask);
+void setLevel(Level level);
+void setSink(Sink sink);
+bool hasSink();
+
+namespace detail {
+extern std::atomic<unsigned> s_categories;
+extern std::atomic<int> s_level;
+}
+
+inline bool enabled(Category category, Level level)
+{
+    return (detail::s_categories.load(std::memory_order_relaxed) & unsigned(category)) != 0
+           && int(level) >= detail::s_level.load(std::memory_order_relaxed);
+}
+
+// 写入环形缓冲（多生产者无锁，满时覆盖最旧记录）
+void record(Category category, Level level, const char *format, int a0 = 0, int a1 = 0, int a2 = 0, int a3 = 0);
+
+// 取出自上次 drain 以来的记录，格式化后交给 sink；返回输出条数。单消费者
+int drain();
+// 因被覆盖或读到一半被改写而丢弃的记录数（累计）
+uint64_t droppedRecords();
+
+// 棋盘快照按行格式化后直接交给 sink；只应在 hasSink() 时调用（由宏保证）
+void dumpBoard(Category category, const char *label, const TileGrid &board);
+}
+
+#ifdef MATCH3_TRACE
+#define M3_TRACE(category, level, ...) \
+    do { if (Trace::enabled(Trace::category, Trace::level)) Trace::record(Trace::category, Trace::level, __VA_ARGS__); } while (0)
+// 棋盘快照：没有 sink 时连格式化都不做
+#define M3_TRACE_BOARD(category, label, board) \
+    do { if (Trace::enabled(Trace::category, Trace::Level_Debug) && Trace::hasSink()) Trace::dumpBoard(Trace::category, label, board); } while (0)
+#else
+#define M3_TRACE(category, level, ...) do { } while (0)
+#define M3_TRACE_BOARD(category, label, board) do { } while (0)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,51 @@
+﻿#include "UndoHistory.h"
+#include "Match3Engine.h"
+
+UndoHistory::UndoHistory(int capacity)
+    : m_capacity(capacity < 2 ? 2 : capacity)
+{
+}
+
+void UndoHistory::reset(const Match3Engine &engine)
+{
+    const size_t size = engine.snapshotSize();
+    if (size != m_slotSize) {
+        m_slotSize = size;
+        m_buffer.assign(size * size_t(m_capacity), 0);
+    }
+    m_first = 0;
+    m_count = 1;
+    m_cursor = 0;
+    engine.saveSnapshot(slot(0));
+}
+
+void UndoHistory::push(const Match3Engine &engine)
+{
+    // 棋盘尺寸变了（或尚未 reset）：旧局面无法恢复，以当前局面重新开始
+    if (m_count == 0 || engine.snapshotSize() != m_slotSize) {
+        reset(engine);
+        return;
+    }
+    m_count = m_cursor + 1;
+    if (m_count == m_capacity) {
+        m_first = (m_first + 1) % m_capacity;
+        --m_count;
+    }
+    engine.saveSnapshot(slot(m_count));
+    m_cursor = m_count;
+    ++m_count;
+}
+
+bool UndoHistory::undo(Match3Engine &engine)
+{
+    if (!canUndo() || !engine.restoreSnapshot(slot(m_cursor - 1))) return false;
+    --m_cursor;
+    return true;
+}
+
+bool UndoHistory::redo(Match3Engine &engine)
+{
+    if (!canRedo() || !engine.restoreSnapshot(slot(m_cursor + 1))) return false;
+    ++m_cursor;
+    return true;
+}
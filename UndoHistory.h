@@ -0,0 +1,42 @@
+﻿#ifndef UNDOHISTORY_H
+#define UNDOHISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Match3Engine;
+
+// 有界撤销/重做：环形保存最近 capacity 个局面的引擎快照（Match3Engine::saveSnapshot 的平坦字节）。
+// 槽位在 reset 时按快照大小一次分配，之后记录、撤销、重做都只是字节拷贝
+class UndoHistory
+{
+public:
+    // capacity 为保存的局面数（含起点），即最多可撤销 capacity - 1 步
+    explicit UndoHistory(int capacity = 32);
+
+    // 以 engine 当前局面为起点清空历史（开局、重置）
+    void reset(const Match3Engine &engine);
+    // 记录一步之后的局面：丢弃可重做的局面，满时丢弃最旧的局面
+    void push(const Match3Engine &engine);
+
+    bool canUndo() const { return m_cursor > 0; }
+    bool canRedo() const { return m_cursor + 1 < m_count; }
+    // 把 engine 恢复到上一个 / 下一个局面；没有可撤销 / 可重做的局面时返回 false
+    bool undo(Match3Engine &engine);
+    bool redo(Match3Engine &engine);
+
+    int capacity() const { return m_capacity; }
+
+private:
+    uint8_t *slot(int i) { return m_buffer.data() + size_t((m_first + i) % m_capacity) * m_slotSize; }
+
+    int m_capacity;
+    size_t m_slotSize = 0;
+    std::vector<uint8_t> m_buffer;  // m_capacity 个定长槽位
+    int m_first = 0;                // 最旧局面所在槽位
+    int m_count = 0;                // 已保存的局面数
+    int m_cursor = 0;               // 当前局面（相对最旧局面）
+};
+
+#endif // UNDOHISTORY_H
@@ -4,9 +4,7 @@ Item {
     id: animManager
     property var boardView
     property var gameBoard
-    property var tileMap: ({})
-    // internal warm-up bookkeeping (avoid dynamic property assignment errors)
-    property var _warmAnims: []
+    property var tileRepeater         // 棋盘 Repeater（模型为 gameBoard.boardModel，下标 = row * columns + col）
     property bool _warmed: false
     property real cellSize: 50
     property bool busy: false
@@ -16,6 +14,12 @@ Item {
     property var matchQueue: []
     property var dropQueue: []
 
+    // ===== 对象池 =====
+    // 动画/特效对象只在池空时由预声明的 Component 实例化一次，播放结束后归还复用，
+    // 不再在每次交换、每个下落方块、每个 GIF 上用 Qt.createQmlObject 现场编译 QML 源码
+    property var _pools: ({ tween: [], gif: [], delay: [], ripple: [] })
+    property int pooledObjects: 0     // 累计实例化的池对象数（稳定后不再增长）
+
     // ===== 连接游戏板信号 =====
     onGameBoardChanged: {
         if (gameBoard) {
@@ -24,30 +28,257 @@ Item {
             gameBoard.dropAnimationRequested.connect(enqueueDrops);
             gameBoard.rollbackSwap.connect(rollbackSwap);
             console.log("动画管理器已连接到游戏板");
-            // 预热：提前创建常用动画对象，避免首次创建时在交换动画中卡顿
+            // 预热：提前填充对象池，避免首次连锁时集中实例化造成卡顿
             try { warmUpAnimations(); } catch(e) { console.log('warmUpAnimations failed', e); }
         }
     }
 
-    // 预热函数：创建少量动画对象并在短时后销毁，触发 QML 引擎解析/加载开销
+    // 预热函数：按棋盘格子数预先实例化补间，并各准备少量 GIF / 定时器 / 涟漪
     function warmUpAnimations() {
         if (animManager._warmed) return;
-        try {
-            var a1 = Qt.createQmlObject('import QtQuick 2.15; ParallelAnimation { NumberAnimation { property: "offsetX"; duration: 1 } NumberAnimation { property: "offsetY"; duration: 1 } }', animManager);
-            var a2 = Qt.createQmlObject('import QtQuick 2.15; SequentialAnimation { ParallelAnimation { NumberAnimation { property: "scale"; duration: 1 } NumberAnimation { property: "opacity"; duration: 1 } } }', animManager);
-            animManager._warmAnims = [a1, a2];
-            var cleaner = Qt.createQmlObject('import QtQuick 2.15; Timer { interval: 200; repeat: false }', animManager);
-            cleaner.triggered.connect(function(){ try { for(var i=0;i<animManager._warmAnims.length;i++){ try{ animManager._warmAnims[i].destroy(); }catch(e){} } animManager._warmAnims = []; } catch(e){} });
-            cleaner.start();
-            animManager._warmed = true;
-            console.log('warmUpAnimations: created warm objects');
-        } catch(e) { console.log('warmUpAnimations error', e); }
+        var cells = gameBoard ? gameBoard.rows * gameBoard.columns : 64;
+        _prefill("tween", tweenComponent, animManager, cells * 2);
+        _prefill("gif", gifComponent, animManager, 4);
+        _prefill("delay", delayComponent, animManager, 4);
+        if (boardView) _prefill("ripple", rippleComponent, boardView, 2);
+        animManager._warmed = true;
+        console.log('warmUpAnimations: pooled objects', pooledObjects);
+    }
+
+    function _prefill(kind, component, parent, count) {
+        var pool = _pools[kind];
+        for (var i = pool.length; i < count; ++i) {
+            var obj = component.createObject(parent);
+            if (!obj) return;
+            pooledObjects++;
+            pool.push(obj);
+        }
+    }
+
+    function _lease(kind, component, parent) {
+        var pool = _pools[kind];
+        if (pool.length > 0) return pool.pop();
+        pooledObjects++;
+        return component.createObject(parent || animManager);
+    }
+
+    function _release(kind, obj) {
+        _pools[kind].push(obj);
+    }
+
+    // ===== 补间 =====
+    // 播放一个最多两段的补间：可选的前置停顿 + phases[0] + phases[1]。
+    // 每段形如 { duration: 150, easing: Easing.OutQuad, scale: 1.2, opacity: { from: 1, to: 0, easing: Easing.InQuad } }，
+    // 除 duration / easing 外的键为属性名（每段最多两个），值为目标值或 { from, to, easing }；
+    // 未给 from 时从该属性当前值（或上一段的目标值）开始
+    function tween(target, phases, done, pauseMs) {
+        var t = _lease("tween", tweenComponent, animManager);
+        t.pauseAnim.duration = pauseMs || 0;
+        var last = {};
+        for (var p = 0; p < 2; ++p) {
+            var phase = phases[p];
+            var names = [];
+            if (phase) {
+                for (var key in phase) {
+                    if (key !== "duration" && key !== "easing") names.push(key);
+                }
+            }
+            for (var k = 0; k < 2; ++k) {
+                var anim = t.tracks[p * 2 + k];
+                var name = names[k];
+                if (!name) {
+                    anim.target = null; anim.property = ""; anim.duration = 0;
+                    continue;
+                }
+                var spec = phase[name];
+                var isObj = (typeof spec === "object");
+                var start = (name in last) ? last[name] : target[name];
+                anim.target = target;
+                anim.property = name;
+                anim.from = (isObj && spec.from !== undefined) ? spec.from : start;
+                anim.to = isObj ? spec.to : spec;
+                anim.duration = phase.duration;
+                anim.easing.type = (isObj && spec.easing !== undefined) ? spec.easing
+                                 : (phase.easing !== undefined ? phase.easing : Easing.Linear);
+                last[name] = anim.to;
+            }
+        }
+        t.doneCallback = done || null;
+        t.start();
+        return t;
+    }
+
+    function _tweenFinished(t) {
+        var cb = t.doneCallback;
+        t.doneCallback = null;
+        for (var i = 0; i < t.tracks.length; ++i) t.tracks[i].target = null;
+        _release("tween", t);
+        if (cb) cb();
+    }
+
+    // 延时回调（代替一次性的 Timer 对象）
+    function after(ms, fn) {
+        var d = _lease("delay", delayComponent, animManager);
+        d.callback = fn;
+        d.interval = Math.max(1, ms);
+        d.start();
+        return d;
+    }
+
+    function _delayFinished(d) {
+        var cb = d.callback;
+        d.callback = null;
+        _release("delay", d);
+        if (cb) cb();
+    }
+
+    // 一次性 GIF：durationMs 后归还，提前 preStopMs 停止播放并隐藏，避免残留最后一帧
+    function _playGif(x, y, w, h, source, fillMode, durationMs, preStopMs) {
+        var gif = _lease("gif", gifComponent, animManager);
+        gif.play(x, y, w, h, source, fillMode, durationMs || 700, preStopMs);
+        return gif;
+    }
+
+    Component {
+        id: tweenComponent
+        SequentialAnimation {
+            id: tweenAnim
+            property var doneCallback: null
+            property alias pauseAnim: tweenPause
+            property var tracks: [tweenA1, tweenA2, tweenB1, tweenB2]
+            PauseAnimation { id: tweenPause; duration: 0 }
+            ParallelAnimation {
+                NumberAnimation { id: tweenA1 }
+                NumberAnimation { id: tweenA2 }
+            }
+            ParallelAnimation {
+                NumberAnimation { id: tweenB1 }
+                NumberAnimation { id: tweenB2 }
+            }
+            onFinished: animManager._tweenFinished(tweenAnim)
+        }
+    }
+
+    Component {
+        id: delayComponent
+        Timer {
+            id: delayTimer
+            property var callback: null
+            repeat: false
+            onTriggered: animManager._delayFinished(delayTimer)
+        }
+    }
+
+    Component {
+        id: gifComponent
+        AnimatedImage {
+            id: pooledGif
+            property int releaseDelay: 0
+            property bool stopped: false
+            z: 9999
+            visible: false
+            playing: false
+            cache: false
+            smooth: true
+
+            function play(px, py, pw, ph, src, fill, durationMs, preStopMs) {
+                gifTimer.stop();
+                x = px; y = py; width = pw; height = ph;
+                fillMode = fill;
+                opacity = 1.0;
+                source = src;
+                visible = true;
+                playing = true;
+                stopped = false;
+                releaseDelay = Math.min(preStopMs, durationMs - 1);
+                gifTimer.interval = Math.max(1, durationMs - releaseDelay);
+                gifTimer.start();
+            }
+
+            Timer {
+                id: gifTimer
+                repeat: false
+                onTriggered: {
+                    if (!pooledGif.stopped) {
+                        // 先停止并清空 source，再等剩余时间后归还
+                        pooledGif.playing = false;
+                        pooledGif.visible = false;
+                        pooledGif.source = "";
+                        pooledGif.stopped = true;
+                        interval = Math.max(1, pooledGif.releaseDelay);
+                        start();
+                    } else {
+                        pooledGif.stopped = false;
+                        animManager._release("gif", pooledGif);
+                    }
+                }
+            }
+        }
+    }
+
+    // 超级+超级的涟漪与白色冲击波（父对象为 boardView，坐标为棋盘内坐标）
+    Component {
+        id: rippleComponent
+        Item {
+            id: ripple
+            width: parent ? parent.width : 0
+            height: parent ? parent.height : 0
+            visible: false
+            property real cx: 0
+            property real cy: 0
+
+            function play(px, py, maxSize, duration) {
+                rippleAnim.stop(); shockAnim.stop();
+                cx = px; cy = py;
+                rippleCircle.width = 0; rippleCircle.height = 0; rippleCircle.opacity = 1;
+                rippleShock.width = 0; rippleShock.height = 0; rippleShock.opacity = 1;
+                circleW.to = maxSize; circleH.to = maxSize;
+                circleW.duration = duration; circleH.duration = duration; circleO.duration = duration;
+                var sdur = Math.floor(duration * 0.6);
+                var ssize = Math.floor(maxSize * 0.8);
+                shockW.to = ssize; shockH.to = ssize;
+                shockW.duration = sdur; shockH.duration = sdur; shockO.duration = sdur;
+                visible = true;
+                rippleAnim.start();
+                shockAnim.start();
+            }
+
+            // 主涟漪圈（圆形），x/y 绑定到中心坐标，随宽高变化保持圆心在 (cx, cy)
+            Rectangle {
+                id: rippleCircle
+                color: "transparent"; border.width: 3; border.color: "#60FFFFFF"
+                radius: width / 2
+                x: ripple.cx - width / 2
+                y: ripple.cy - height / 2
+            }
+            // 白色冲击波（圆形）
+            Rectangle {
+                id: rippleShock
+                color: "transparent"; border.width: 6; border.color: "#B0FFFFFF"
+                radius: width / 2
+                x: ripple.cx - width / 2
+                y: ripple.cy - height / 2
+            }
+            ParallelAnimation {
+                id: rippleAnim
+                NumberAnimation { id: circleW; target: rippleCircle; property: "width"; easing.type: Easing.OutCubic }
+                NumberAnimation { id: circleH; target: rippleCircle; property: "height"; easing.type: Easing.OutCubic }
+                NumberAnimation { id: circleO; target: rippleCircle; property: "opacity"; from: 1; to: 0; easing.type: Easing.OutQuad }
+                onFinished: { ripple.visible = false; animManager._release("ripple", ripple); }
+            }
+            ParallelAnimation {
+                id: shockAnim
+                NumberAnimation { id: shockW; target: rippleShock; property: "width"; easing.type: Easing.OutCubic }
+                NumberAnimation { id: shockH; target: rippleShock; property: "height"; easing.type: Easing.OutCubic }
+                NumberAnimation { id: shockO; target: rippleShock; property: "opacity"; from: 1; to: 0; easing.type: Easing.OutQuad }
+            }
+        }
     }
 
     function findTile(row, col) {
-        // console.log("Searching for tile: " + row + "_" + col);
-        // console.log("TileMap: ", tileMap);
-        return tileMap[row + "_" + col] || null;
+        if (!tileRepeater || !gameBoard) return null;
+        if (row < 0 || row >= gameBoard.rows || col < 0 || col >= gameBoard.columns) return null;
+        return tileRepeater.itemAt(row * gameBoard.columns + col);
     }
 
     // ===== 队列入列函数 =====
@@ -79,27 +310,15 @@ Item {
         if(!t1||!t2){ busy=false; runNext(); return; }
         var dx=(c2-c1)*cellSize, dy=(r2-r1)*cellSize;
 
-        var anim1=Qt.createQmlObject(`import QtQuick 2.15; ParallelAnimation { NumberAnimation { property: "offsetX"; duration: 200 } NumberAnimation { property: "offsetY"; duration: 200 } }`, animManager);
-        anim1.animations[0].target=t1; anim1.animations[0].from=0; anim1.animations[0].to=dx;
-        anim1.animations[1].target=t1; anim1.animations[1].from=0; anim1.animations[1].to=dy;
-
-        var anim2=Qt.createQmlObject(`import QtQuick 2.15; ParallelAnimation { NumberAnimation { property: "offsetX"; duration: 200 } NumberAnimation { property: "offsetY"; duration: 200 } }`, animManager);
-        anim2.animations[0].target=t2; anim2.animations[0].from=0; anim2.animations[0].to=-dx;
-        anim2.animations[1].target=t2; anim2.animations[1].from=0; anim2.animations[1].to=-dy;
-
         var completed=0;
         function onFinished(){ completed++; if(completed===2){
             t1.offsetX=0;t1.offsetY=0; t2.offsetX=0;t2.offsetY=0;
             // 后端c++处理匹配结果
             gameBoard.finalizeSwap(r1,c1,r2,c2,false);
-            // 更新 tileMap
-            tileMap[r1+"_"+c1]=findTile(r1,c1);
-            tileMap[r2+"_"+c2]=findTile(r2,c2);
             busy=false; runNext();
         }}
-        anim1.onFinished.connect(onFinished);
-        anim2.onFinished.connect(onFinished);
-        anim1.start(); anim2.start();
+        tween(t1, [{ duration: 200, offsetX: { from: 0, to: dx }, offsetY: { from: 0, to: dy } }], onFinished);
+        tween(t2, [{ duration: 200, offsetX: { from: 0, to: -dx }, offsetY: { from: 0, to: -dy } }], onFinished);
     }
 
     function rollbackSwap(r1,c1,r2,c2){
@@ -109,9 +328,7 @@ Item {
         if(!t1||!t2){ busy=false; return; }
 
         [t1,t2].forEach(function(t){
-            var rollback=Qt.createQmlObject(`import QtQuick 2.15; ParallelAnimation { NumberAnimation { property: "offsetX"; to:0; duration:200 } NumberAnimation { property: "offsetY"; to:0; duration:200 } }`, animManager);
-            rollback.animations[0].target=t; rollback.animations[1].target=t;
-            rollback.start();
+            tween(t, [{ duration: 200, offsetX: 0, offsetY: 0 }]);
         });
 
         shakeTile(t1); shakeTile(t2);
@@ -119,6 +336,13 @@ Item {
         busy=false;
     }
 
+    // 无效交换 / 回滚时的左右抖动
+    function shakeTile(tile){
+        if(!tile) return;
+        tween(tile, [{ duration: 50, easing: Easing.OutQuad, offsetX: 6 },
+                     { duration: 100, easing: Easing.OutBounce, offsetX: 0 }]);
+    }
+
     // ===== 匹配动画 =====
     function runMatches(matchedTiles){
         if(!matchedTiles||matchedTiles.length===0){ busy=false; runNext(); return; }
@@ -126,93 +350,24 @@ Item {
         matchedTiles.forEach(function(pt){
             var tile=findTile(pt.x,pt.y);
             if(!tile){ pending--; return; }
-            var anim=Qt.createQmlObject(`
-                import QtQuick 2.15
-                SequentialAnimation {
-                    ParallelAnimation { NumberAnimation { property:"scale"; to:1.2; duration:150; easing.type:Easing.OutQuad }
-                                       NumberAnimation { property:"opacity"; to:0.5; duration:150; easing.type:Easing.OutQuad } }
-                    ParallelAnimation { NumberAnimation { property: "scale"; to: 1.0; duration: 150; easing.type:Easing.InQuad }
-                                       NumberAnimation { property: "opacity"; to: 1.0; duration: 150; easing.type:Easing.InQuad } }
-                }
-            `, animManager);
-            anim.animations[0].animations[0].target=tile;
-            anim.animations[0].animations[1].target=tile;
-            anim.animations[1].animations[0].target=tile;
-            anim.animations[1].animations[1].target=tile;
-            anim.onFinished.connect(function(){ pending--; if(pending===0){ busy=false; runNext(); } });
-            anim.start();
+            tween(tile, [{ duration: 150, easing: Easing.OutQuad, scale: 1.2, opacity: 0.5 },
+                         { duration: 150, easing: Easing.InQuad, scale: 1.0, opacity: 1.0 }],
+                  function(){ pending--; if(pending===0){ busy=false; runNext(); } });
         });
     }
 
     // ===== 掉落动画 =====
-    function refreshBoardColors() {
-        if (!gameBoard) return;
-        for (var key in tileMap) {
-            var parts = key.split("_");
-            var r = parseInt(parts[0]);
-            var c = parseInt(parts[1]);
-            var tile = tileMap[key];
-            if (tile && typeof gameBoard.getTileColor === "function") {
-                tile.tileColor = gameBoard.getTileColor(r, c);
-            }
-        }
-    }
-    function runDrops(dropPaths){
-        console.log("runDrops called, dropPaths:", dropPaths);
-         if(!dropPaths||dropPaths.length===0){
-             console.log("runDrops: empty dropPaths, calling commitDrop");
-             // 即使没有移动路径，也需要让后端执行 commitDrop（填充新方块并检测连锁）
-             if (gameBoard && typeof gameBoard.commitDrop === "function") {
-                 gameBoard.commitDrop();
-             }
-             busy=false; runNext();
-             return;
-         }
-        var pending=0;
-        var commitCalled=false;
-        dropPaths.forEach(function(path){
-            for(var j=path.length-1;j>0;j--){
-                var from=path[j-1], to=path[j];
-                var tileFrom=findTile(from.x,from.y), tileTo=findTile(to.x,to.y);
-                if(!tileFrom||!tileTo) continue;
-                // 直接更新目标颜色（数据最终由后端 commitDrop 写入），动画仅为位移动画
-                tileTo.tileColor=tileFrom.tileColor;
-                tileFrom.tileColor="transparent";
-
-                // 使用 offsetY 做下落位移动画，不改变 scale
-                var anim=Qt.createQmlObject(`
-                    import QtQuick 2.15
-                    SequentialAnimation {
-                        NumberAnimation { property: "offsetY"; from: -animManager.cellSize; to: 0; duration: 180; easing.type: Easing.OutCubic }
-                    }
-                `, animManager);
-                anim.animations[0].target=tileTo;
-
-                pending++;
-                (function(a, target){ a.onFinished.connect(function(){
-                    // 重置偏移并减少计数
-                    if (target) target.offsetY = 0;
-                    pending--; if(pending===0){
-                        // 所有掉落动画完成后，通知后端把实际棋盘状态同步（应用重力并填充）
-                        if (!commitCalled && gameBoard && typeof gameBoard.commitDrop === "function") {
-                            commitCalled = true;
-                            gameBoard.commitDrop();
-                        }
-                        busy=false; runNext();
-                    }
-                }); a.start(); })(anim, tileTo);
-            }
+    // 下落后的棋盘已由模型下发，各格委托按模型的 dropOffset 自行播放下落（见 main.qml）；
+    // 这里只按最长的下落路径等待动画结束，再通知后端 commitDrop 继续回放
+    function dropDuration(rows) { return Math.min(480, 140 + 40 * rows); }
 
-            var top=path[0];
-            if(top && top.x<0){
-                var newColor="gray";
-                if(gameBoard && typeof gameBoard.getRandomColorQml==="function")
-                    newColor=gameBoard.getRandomColorQml();
-                var topTile=findTile(top.x,top.y);
-                if(topTile) topTile.tileColor=newColor;
-            }
+    function runDrops(dropPaths){
+        var rows = 0;
+        if (dropPaths) dropPaths.forEach(function(path){ rows = Math.max(rows, path.length - 1); });
+        after(rows > 0 ? dropDuration(rows) : 0, function(){
+            if (gameBoard && typeof gameBoard.commitDrop === "function") gameBoard.commitDrop();
+            busy=false; runNext();
         });
-        if(pending===0){ refreshBoardColors(); if (!commitCalled && gameBoard && typeof gameBoard.commitDrop === "function") { commitCalled = true; gameBoard.commitDrop(); } busy=false; runNext(); }
     }
 
     // 统一自适应：基于棋盘尺寸生成线性 GIF（行/列）
@@ -231,15 +386,9 @@ Item {
         var mapped = boardView.mapToItem(animManager, localX, localY);
         var w = isVertical ? thickness : length;
         var h = isVertical ? length : thickness;
-        var gif = Qt.createQmlObject('import QtQuick 2.15; AnimatedImage { x: ' + (mapped.x - w/2) + '; y: ' + (mapped.y - h/2) + '; width: ' + w + '; height: ' + h + '; z: 9999; source: "' + source + '"; playing: true; cache: false; fillMode: Image.Stretch; smooth: true }', animManager);
-        console.log('showLineGifAtRowCol: created line gif', source, 'at', row, col, 'vertical?', isVertical, 'size', w, h, 'duration', durationMs);
-        var killer = Qt.createQmlObject('import QtQuick 2.15; Timer { interval: ' + (durationMs || 700) + '; repeat: false }', animManager);
-        killer.triggered.connect(function(){ console.log('showLineGifAtRowCol: killer triggered for', source, row, col); if(gif) { try { gif.playing = false; gif.visible = false; gif.source = ""; } catch(e){} try { gif.destroy(); } catch(e){} } });
-        killer.start();
-        // stop playback slightly before destruction
-        var stopper2 = Qt.createQmlObject('import QtQuick 2.15; Timer { interval: ' + (Math.max(1, (durationMs || 700) - 80)) + '; repeat: false }', animManager);
-        stopper2.triggered.connect(function(){ console.log('showLineGifAtRowCol: stopper triggered for', source, row, col); try { if(gif) { gif.playing = false; gif.visible = false; gif.source = ""; if (typeof gif.frame !== 'undefined') gif.frame = 0; } } catch(e){} });
-        stopper2.start();
+        // stop playback slightly before release
+        var gif = _playGif(mapped.x - w/2, mapped.y - h/2, w, h, source, Image.Stretch, durationMs || 700, 80);
+        console.log('showLineGifAtRowCol: line gif', source, 'at', row, col, 'vertical?', isVertical, 'size', w, h, 'duration', durationMs);
         return gif;
     }
 
@@ -265,12 +414,8 @@ Item {
 
         var pending = tilesToClear.length;
         tilesToClear.forEach(function(tile){
-            var anim = Qt.createQmlObject('import QtQuick 2.15; SequentialAnimation { ParallelAnimation { NumberAnimation { property: "scale"; to: 0; duration: 200; easing.type: Easing.InQuad } NumberAnimation { property: "opacity"; to: 0; duration: 200; easing.type: Easing.InQuad } } }', animManager);
-            // 修正：SequentialAnimation 中只有一个 ParallelAnimation，不能访问 animations[1]
-            anim.animations[0].animations[0].target = tile;
-            anim.animations[0].animations[1].target = tile;
-            anim.onFinished.connect(function(){ pending--; if (pending === 0) { gameBoard.rocketEffectTriggered(row, col, type); } });
-            anim.start();
+            tween(tile, [{ duration: 200, easing: Easing.InQuad, scale: 0, opacity: 0 }],
+                  function(){ pending--; if (pending === 0) { gameBoard.rocketEffectTriggered(row, col, type); } });
         });
     }
 
@@ -286,13 +431,13 @@ Item {
         // 收集三行/三列
         if (isVertical) {
             for (var dc = -1; dc <= 1; ++dc) {
-                var cc = col + dc; if(cc<0||cc>=8) continue;
-                for (var r = 0; r < 8; ++r) { var t = findTile(r, cc); if(t) affected.push(t); }
+                var cc = col + dc; if(cc<0||cc>=gameBoard.columns) continue;
+                for (var r = 0; r < gameBoard.rows; ++r) { var t = findTile(r, cc); if(t) affected.push(t); }
             }
         } else {
             for (var dr = -1; dr <= 1; ++dr) {
-                var rr = row + dr; if(rr<0||rr>=8) continue;
-                for (var c = 0; c < 8; ++c) { var t2 = findTile(rr, c); if(t2) affected.push(t2); }
+                var rr = row + dr; if(rr<0||rr>=gameBoard.rows) continue;
+                for (var c = 0; c < gameBoard.columns; ++c) { var t2 = findTile(rr, c); if(t2) affected.push(t2); }
             }
         }
         // 去重 + 后端触发
@@ -302,10 +447,8 @@ Item {
         if(unique.length===0){ console.log("runComboBombRocket: none, backend"); gameBoard.bombRocketTriggered(row,col,rocketType); return; }
         var pending = unique.length;
         unique.forEach(function(tile){
-            var anim = Qt.createQmlObject('import QtQuick 2.15; SequentialAnimation { ParallelAnimation { NumberAnimation { property:"scale"; to:0; duration:200 } NumberAnimation { property:"opacity"; to:0; duration:200 } } }', animManager);
-            anim.animations[0].animations[0].target = tile; anim.animations[0].animations[1].target = tile;
-            anim.onFinished.connect(function(){ pending--; if(pending===0){ console.log("runComboBombRocket: visuals done, calling backend"); gameBoard.bombRocketTriggered(row,col,rocketType); } });
-            anim.start();
+            tween(tile, [{ duration: 200, scale: 0, opacity: 0 }],
+                  function(){ pending--; if(pending===0){ console.log("runComboBombRocket: visuals done, calling backend"); gameBoard.bombRocketTriggered(row,col,rocketType); } });
         });
     }
 
@@ -316,15 +459,16 @@ Item {
         if (!color && gameBoard && typeof gameBoard.getTileColor === 'function') {
             try { color = gameBoard.getTileColor(row, col); console.log('runBombEffect: fallback color from gameBoard:', color); } catch(e) { console.log('runBombEffect: fallback color failed', e); color = ""; }
         }
-        // 播放自适配小炸弹 GIF（5.5 格直径），并在 700ms 后销毁
-        showGifAt(row, col, 'qrc:/image/Animated/smallbomb.gif', 700, { tileSpan: 5.5 });
+        // 半径取自引擎（BombType = 3），高亮与实际清除范围一致
+        var radius = gameBoard.blastRadius(3);
+        // 播放自适配小炸弹 GIF（直径为爆炸直径 + 1.5 格，默认半径 2 时为 5.5 格），并在 700ms 后归还
+        showGifAt(row, col, 'qrc:/image/Animated/smallbomb.gif', 700, { tileSpan: radius * 2 + 1.5 });
 
-        // 收集半径 2 的圆形范围内的格子
+        // 收集圆形范围内的格子
         var affected = [];
-        var radius = 2;
         for (var r = row - radius; r <= row + radius; ++r) {
             for (var c = col - radius; c <= col + radius; ++c) {
-                if (r >= 0 && r < 8 && c >= 0 && c < 8) {
+                if (r >= 0 && r < gameBoard.rows && c >= 0 && c < gameBoard.columns) {
                     var dr = r - row, dc = c - col;
                     if (dr*dr + dc*dc <= radius*radius) {
                         var t = findTile(r, c);
@@ -342,11 +486,8 @@ Item {
 
         var pending = affected.length;
         affected.forEach(function(tile){
-            var anim = Qt.createQmlObject('import QtQuick 2.15; SequentialAnimation { ParallelAnimation { NumberAnimation { property:"scale"; from:1; to:1.4; duration:180; easing.type: Easing.OutQuad } NumberAnimation { property:"opacity"; from:1; to:0; duration:180; easing.type: Easing.InQuad } } }', animManager);
-            anim.animations[0].animations[0].target = tile;
-            anim.animations[0].animations[1].target = tile;
-            anim.onFinished.connect(function(){ pending--; if (pending === 0) { gameBoard.bombEffectTriggered(row, col, color); } });
-            anim.start();
+            tween(tile, [{ duration: 180, scale: { from: 1, to: 1.4, easing: Easing.OutQuad }, opacity: { from: 1, to: 0, easing: Easing.InQuad } }],
+                  function(){ pending--; if (pending === 0) { gameBoard.bombEffectTriggered(row, col, color); } });
         });
     }
 
@@ -361,20 +502,15 @@ Item {
             var localCx = tile ? (tile.x + tile.width/2) : (boardView.offsetX + col * cell + cell/2);
             var localCy = tile ? (tile.y + tile.height/2) : (boardView.offsetY + row * cell + cell/2);
             var mappedC = boardView.mapToItem(animManager, localCx, localCy);
-            var cGif = Qt.createQmlObject('import QtQuick 2.15; AnimatedImage { x: ' + (mappedC.x - maxDiam/2) + '; y: ' + (mappedC.y - maxDiam/2) + '; width: ' + maxDiam + '; height: ' + maxDiam + '; z: 9999; source: "qrc:/image/Animated/lighting_circle.gif"; playing: true; cache: false; fillMode: Image.PreserveAspectFit; smooth: true }', animManager);
-            console.log('runSuperItemEffect: created cGif at', row, col, 'diam', maxDiam);
-            var cTimer = Qt.createQmlObject('import QtQuick 2.15; Timer { interval: 800; repeat: false }', animManager);
-            cTimer.triggered.connect(function(){ console.log('runSuperItemEffect: cTimer triggered'); if(cGif) { try { cGif.playing = false; cGif.visible = false; cGif.source = ""; } catch(e){} try { cGif.destroy(); } catch(e){} } });
-            cTimer.start();
-            // stop playback slightly before destruction to avoid extra lingering frames
-            var cStopper = Qt.createQmlObject('import QtQuick 2.15; Timer { interval: 720; repeat: false }', animManager);
-            cStopper.triggered.connect(function(){ console.log('runSuperItemEffect: cStopper triggered'); try { if(cGif) { cGif.playing = false; cGif.visible = false; cGif.source = ""; if (typeof cGif.frame !== 'undefined') cGif.frame = 0; } } catch(e){} });
-            cStopper.start();
+            // stop playback slightly before release to avoid extra lingering frames
+            _playGif(mappedC.x - maxDiam/2, mappedC.y - maxDiam/2, maxDiam, maxDiam,
+                     "qrc:/image/Animated/lighting_circle.gif", Image.PreserveAspectFit, 800, 80);
+            console.log('runSuperItemEffect: circle gif at', row, col, 'diam', maxDiam);
         }
 
         var matchedTiles = [];
-        for (var r = 0; r < 8; r++) {
-            for (var c = 0; c < 8; c++) {
+        for (var r = 0; r < gameBoard.rows; r++) {
+            for (var c = 0; c < gameBoard.columns; c++) {
                 if (gameBoard.tileAt(r, c) === color) {
                     var t = findTile(r, c);
                     if (t) matchedTiles.push(t);
@@ -390,21 +526,9 @@ Item {
 
         var pending = matchedTiles.length;
         matchedTiles.forEach(function(tile) {
-            var anim = Qt.createQmlObject(`
-                import QtQuick 2.15
-                SequentialAnimation {
-                    ParallelAnimation { NumberAnimation { property: "scale"; from: 1; to: 1.2; duration: 120; easing.type: Easing.OutQuad }
-                                       NumberAnimation { property: "opacity"; from: 1; to: 0.6; duration: 120 } }
-                    ParallelAnimation { NumberAnimation { property: "scale"; from: 1.2; to: 1.5; duration: 180; easing.type: Easing.OutElastic }
-                                       NumberAnimation { property: "opacity"; from: 0.6; to: 0; duration: 180 } }
-                }
-            `, animManager);
-            anim.animations[0].animations[0].target = tile;
-            anim.animations[0].animations[1].target = tile;
-            anim.animations[1].animations[0].target = tile;
-            anim.animations[1].animations[1].target = tile;
-            anim.onFinished.connect(function(){ pending--; if(pending===0){ gameBoard.superItemEffectTriggered(row, col, color); } });
-            anim.start();
+            tween(tile, [{ duration: 120, scale: { from: 1, to: 1.2, easing: Easing.OutQuad }, opacity: { from: 1, to: 0.6 } },
+                         { duration: 180, scale: { from: 1.2, to: 1.5, easing: Easing.OutElastic }, opacity: { from: 0.6, to: 0 } }],
+                  function(){ pending--; if(pending===0){ gameBoard.superItemEffectTriggered(row, col, color); } });
         });
     }
 
@@ -420,8 +544,8 @@ Item {
                             'qrc:/image/Animated/lighting_V.gif',
                             1.02, 1.6, 700);
         var affected = [];
-        for (var c = 0; c < 8; ++c) { var t = findTile(row, c); if(t) affected.push(t); }
-        for (var r = 0; r < 8; ++r) { var t2 = findTile(r, col); if(t2) affected.push(t2); }
+        for (var c = 0; c < gameBoard.columns; ++c) { var t = findTile(row, c); if(t) affected.push(t); }
+        for (var r = 0; r < gameBoard.rows; ++r) { var t2 = findTile(r, col); if(t2) affected.push(t2); }
         // 去重
         var unique = [];
         var keySet = {};
@@ -429,24 +553,22 @@ Item {
         if(unique.length===0){ console.log("runComboRocketRocket: no tiles, calling backend"); gameBoard.rocketRocketTriggered(row,col); return; }
         var pending = unique.length;
         unique.forEach(function(tile){
-            var anim = Qt.createQmlObject(`import QtQuick 2.15; SequentialAnimation { ParallelAnimation { NumberAnimation { property:"scale"; to:0; duration:220 } NumberAnimation { property:"opacity"; to:0; duration:220 } } }`, animManager);
-            anim.animations[0].animations[0].target = tile; anim.animations[0].animations[1].target = tile;
-            anim.onFinished.connect(function(){ pending--; if(pending===0){ console.log("runComboRocketRocket: visuals done, calling backend"); gameBoard.rocketRocketTriggered(row,col); } });
-            anim.start();
+            tween(tile, [{ duration: 220, scale: 0, opacity: 0 }],
+                  function(){ pending--; if(pending===0){ console.log("runComboRocketRocket: visuals done, calling backend"); gameBoard.rocketRocketTriggered(row,col); } });
         });
     }
 
-    // 炸弹+炸弹 -> 大范围爆炸（半径4）
+    // 炸弹+炸弹 -> 大范围爆炸（半径取自引擎）
     function runComboBombBomb(row, col) {
         console.log("runComboBombBomb: combo at", row, col);
-        // 大炸弹：覆盖约 9.5x9.5 格（500px GIF 更适配），略向上偏移微调
-        showGifAt(row, col, 'qrc:/image/Animated/hugebomb.gif', 950, { tileSpan: 9.5, offsetY: -10 });
+        var radius = gameBoard.blastRadius(101);   // Combo_BombBombType
+        // 大炸弹：覆盖爆炸直径 + 1.5 格（默认半径 4 时约 9.5x9.5 格，500px GIF 更适配），略向上偏移微调
+        showGifAt(row, col, 'qrc:/image/Animated/hugebomb.gif', 950, { tileSpan: radius * 2 + 1.5, offsetY: -10 });
 
-        var radius = 4;
         var affected = [];
         for (var r = row - radius; r <= row + radius; ++r) {
             for (var c = col - radius; c <= col + radius; ++c) {
-                if (r >= 0 && r < 8 && c >= 0 && c < 8) {
+                if (r >= 0 && r < gameBoard.rows && c >= 0 && c < gameBoard.columns) {
                     if ((r-row)*(r-row) + (c-col)*(c-col) <= radius*radius) {
                         var t = findTile(r,c); if(t) affected.push(t);
                     }
@@ -456,10 +578,8 @@ Item {
         if(affected.length===0){ console.log("runComboBombBomb: none, backend"); gameBoard.bombBombTriggered(row,col); return; }
         var pending = affected.length;
         affected.forEach(function(tile){
-            var anim = Qt.createQmlObject(`import QtQuick 2.15; SequentialAnimation { ParallelAnimation { NumberAnimation { property:"scale"; from:1; to:1.6; duration:180 } NumberAnimation { property:"opacity"; from:1; to:0; duration:180 } } }`, animManager);
-            anim.animations[0].animations[0].target = tile; anim.animations[0].animations[1].target = tile;
-            anim.onFinished.connect(function(){ pending--; if(pending===0){ console.log("runComboBombBomb: visuals done, calling backend"); gameBoard.bombBombTriggered(row,col); } });
-            anim.start();
+            tween(tile, [{ duration: 180, scale: { from: 1, to: 1.6 }, opacity: { from: 1, to: 0 } }],
+                  function(){ pending--; if(pending===0){ console.log("runComboBombBomb: visuals done, calling backend"); gameBoard.bombBombTriggered(row,col); } });
         });
     }
 
@@ -471,16 +591,13 @@ Item {
         var dirs = [[-1,0],[1,0],[0,-1],[0,1]];
         for (var i = 0; i < dirs.length; ++i) {
             var rr = row + dirs[i][0]; var cc = col + dirs[i][1];
-            if (rr>=0 && rr<8 && cc>=0 && cc<8) { var t = findTile(rr,cc); if(t) neigh.push(t); }
+            if (rr>=0 && rr<gameBoard.rows && cc>=0 && cc<gameBoard.columns) { var t = findTile(rr,cc); if(t) neigh.push(t); }
         }
         var pending = neigh.length;
         if (pending === 0) { console.log("runComboSuperBomb: no neighbor visuals, calling backend"); gameBoard.superBombTriggered(row,col); return; }
         neigh.forEach(function(tile){
-            var anim = Qt.createQmlObject(`import QtQuick 2.15; SequentialAnimation { NumberAnimation { property:"scale"; to:1.2; duration:120 } NumberAnimation { property:"scale"; to:1.0; duration:120 } }`, animManager);
-            anim.animations[0].target = tile;
-            anim.animations[1].target = tile;
-            anim.onFinished.connect(function(){ pending--; if(pending===0){ console.log("runComboSuperBomb: visuals done, calling backend"); gameBoard.superBombTriggered(row,col); } });
-            anim.start();
+            tween(tile, [{ duration: 120, scale: 1.2 }, { duration: 120, scale: 1.0 }],
+                  function(){ pending--; if(pending===0){ console.log("runComboSuperBomb: visuals done, calling backend"); gameBoard.superBombTriggered(row,col); } });
         });
     }
 
@@ -492,16 +609,13 @@ Item {
         var dirs2 = [[-1,0],[1,0],[0,-1],[0,1]];
         for (var i = 0; i < dirs2.length; ++i) {
             var rr = row + dirs2[i][0]; var cc = col + dirs2[i][1];
-            if (rr>=0 && rr<8 && cc>=0 && cc<8) { var t = findTile(rr,cc); if(t) neigh2.push(t); }
+            if (rr>=0 && rr<gameBoard.rows && cc>=0 && cc<gameBoard.columns) { var t = findTile(rr,cc); if(t) neigh2.push(t); }
         }
         var pending2 = neigh2.length;
         if (pending2 === 0) { console.log("runComboSuperRocket: no neighbor visuals, calling backend"); gameBoard.superRocketTriggered(row,col); return; }
         neigh2.forEach(function(tile){
-            var anim = Qt.createQmlObject(`import QtQuick 2.15; SequentialAnimation { NumberAnimation { property:"scale"; to:1.15; duration:100 } NumberAnimation { property:"scale"; to:1.0; duration:100 } }`, animManager);
-            anim.animations[0].target = tile;
-            anim.animations[1].target = tile;
-            anim.onFinished.connect(function(){ pending2--; if(pending2===0){ console.log("runComboSuperRocket: visuals done, calling backend"); gameBoard.superRocketTriggered(row,col); } });
-            anim.start();
+            tween(tile, [{ duration: 100, scale: 1.15 }, { duration: 100, scale: 1.0 }],
+                  function(){ pending2--; if(pending2===0){ console.log("runComboSuperRocket: visuals done, calling backend"); gameBoard.superRocketTriggered(row,col); } });
         });
     }
 
@@ -513,76 +627,32 @@ Item {
         var cx = centerTile ? centerTile.x + centerTile.width/2 : boardView.x + boardView.width/2;
         var cy = centerTile ? centerTile.y + centerTile.height/2 : boardView.y + boardView.height/2;
 
-        // 生成涟漪与白色冲击波，不使用未绑定标识符
+        // 涟漪与白色冲击波
         function spawnRipplePack(cx, cy, maxSize, duration) {
-            var rippleItem = Qt.createQmlObject('\n                import QtQuick 2.15\n                Item { width: parent ? parent.width : 0; height: parent ? parent.height : 0 }\n            ', boardView);
-            // 主涟漪圈（圆形）
-            var circle = Qt.createQmlObject('\n                import QtQuick 2.15\n                Rectangle { color: "transparent"; border.width: 3; border.color: "#60FFFFFF" }\n            ', rippleItem);
-            circle.width = 0; circle.height = 0;
-            circle.radius = Qt.binding(function(){ return circle.width/2; });
-            // 关键：x/y 绑定到中心坐标，随宽高变化保持圆心在(cx,cy)
-            circle.x = Qt.binding(function(){ return cx - circle.width/2; });
-            circle.y = Qt.binding(function(){ return cy - circle.height/2; });
-            var anim = Qt.createQmlObject('import QtQuick 2.15; ParallelAnimation { ' +
-                'NumberAnimation { property: "width"; to: ' + maxSize + '; duration: ' + duration + '; easing.type: Easing.OutCubic } ' +
-                'NumberAnimation { property: "height"; to: ' + maxSize + '; duration: ' + duration + '; easing.type: Easing.OutCubic } ' +
-                'NumberAnimation { property: "opacity"; from: 1; to: 0; duration: ' + duration + '; easing.type: Easing.OutQuad } ' +
-            '}', rippleItem);
-            anim.animations[0].target = circle;
-            anim.animations[1].target = circle;
-            anim.animations[2].target = circle;
-            anim.onFinished.connect(function(){ rippleItem.destroy(); });
-            anim.start();
-
-            // 白色冲击波（圆形）
-            var shock = Qt.createQmlObject('\n                import QtQuick 2.15\n                Rectangle { color: "transparent"; border.width: 6; border.color: "#B0FFFFFF" }\n            ', rippleItem);
-            shock.width = 0; shock.height = 0;
-            shock.radius = Qt.binding(function(){ return shock.width/2; });
-            // 同步绑定中心
-            shock.x = Qt.binding(function(){ return cx - shock.width/2; });
-            shock.y = Qt.binding(function(){ return cy - shock.height/2; });
-            var sdur = Math.floor(duration*0.6);
-            var ssize = Math.floor(maxSize*0.8);
-            var anim2 = Qt.createQmlObject('import QtQuick 2.15; ParallelAnimation { ' +
-                'NumberAnimation { property: "width"; to: ' + ssize + '; duration: ' + sdur + '; easing.type: Easing.OutCubic } ' +
-                'NumberAnimation { property: "height"; to: ' + ssize + '; duration: ' + sdur + '; easing.type: Easing.OutCubic } ' +
-                'NumberAnimation { property: "opacity"; from: 1; to: 0; duration: ' + sdur + '; easing.type: Easing.OutQuad } ' +
-            '}', rippleItem);
-            anim2.animations[0].target = shock;
-            anim2.animations[1].target = shock;
-            anim2.animations[2].target = shock;
-            anim2.start();
+            var ripple = _lease("ripple", rippleComponent, boardView);
+            if (ripple) ripple.play(cx, cy, maxSize, duration);
         }
 
         // 打击波
         function wavePunch(durationBase, scaleTo) {
             var tiles = [];
-            for (var r = 0; r < 8; r++) {
-                for (var c = 0; c < 8; c++) {
+            for (var r = 0; r < gameBoard.rows; r++) {
+                for (var c = 0; c < gameBoard.columns; c++) {
                     var t = findTile(r, c);
                     if (t) tiles.push(t);
                 }
             }
             var centerRX = row;
             var centerCX = col;
+            var half = Math.floor(durationBase/2);
             tiles.forEach(function(t){
                 var dr = Math.abs(t.row - centerRX);
                 var dc = Math.abs(t.col - centerCX);
                 var ring = Math.max(dr, dc);
                 var delay = ring * 40;
-                var seq = Qt.createQmlObject('import QtQuick 2.15; SequentialAnimation { ' +
-                    'PauseAnimation { duration: ' + delay + ' } ' +
-                    'ParallelAnimation { NumberAnimation { property: "scale"; to: ' + scaleTo + '; duration: ' + Math.floor(durationBase/2) + '; easing.type: Easing.OutBack } ' +
-                    'NumberAnimation { property: "opacity"; to: 0.7; duration: ' + Math.floor(durationBase/2) + '; } } ' +
-                    'ParallelAnimation { NumberAnimation { property: "scale"; to: 1.0; duration: ' + Math.floor(durationBase/2) + '; easing.type: Easing.InBack } ' +
-                    'NumberAnimation { property: "opacity"; to: 0; duration: ' + Math.floor(durationBase/2) + '; } } ' +
-                '}', animManager);
-                seq.animations[1].animations[0].target = t;
-                seq.animations[1].animations[1].target = t;
-                seq.animations[2].animations[0].target = t;
-                seq.animations[2].animations[1].target = t;
-                seq.onFinished.connect(function(){ t.opacity = 1.0; });
-                seq.start();
+                tween(t, [{ duration: half, scale: { to: scaleTo, easing: Easing.OutBack }, opacity: 0.7 },
+                          { duration: half, scale: { to: 1.0, easing: Easing.InBack }, opacity: 0 }],
+                      function(){ t.opacity = 1.0; }, delay);
             });
         }
 
@@ -590,17 +660,13 @@ Item {
         var maxSize = Math.max(boardView.width, boardView.height);
         spawnRipplePack(cx, cy, maxSize, 600);
         wavePunch(300, 1.25);
-        var t1 = Qt.createQmlObject('import QtQuick 2.15; Timer { interval: 620; repeat: false }', animManager);
-        t1.triggered.connect(function(){ gameBoard.superSuperTriggered(row, col); });
-        t1.start();
+        after(620, function(){ gameBoard.superSuperTriggered(row, col); });
 
         // 第二次涟漪 + 打击感动画 + 再次后端清盘（实现两轮全图消除）
-        var t2 = Qt.createQmlObject('import QtQuick 2.15; Timer { interval: 1200; repeat: false }', animManager);
-        t2.triggered.connect(function(){ spawnRipplePack(cx, cy, maxSize, 600); wavePunch(300, 1.25); gameBoard.superSuperTriggered(row, col); });
-        t2.start();
+        after(1200, function(){ spawnRipplePack(cx, cy, maxSize, 600); wavePunch(300, 1.25); gameBoard.superSuperTriggered(row, col); });
     }
 
-    // 通用：在指定棋盘坐标显示一次性 GIF，并在 durationMs 后销毁
+    // 通用：在指定棋盘坐标显示一次性 GIF，并在 durationMs 后归还
     // opts: { tileSpan: number, width: px, height: px, offsetX: px, offsetY: px }
     function showGifAt(row, col, source, durationMs, opts) {
         if (!boardView) return;
@@ -637,43 +703,9 @@ Item {
         var x = cx - w/2 + ox;
         var y = cy - h/2 + oy;
 
-        var gif = Qt.createQmlObject(
-            'import QtQuick 2.15; AnimatedImage { ' +
-            '    x: ' + x + '; y: ' + y + '; width: ' + w + '; height: ' + h + '; ' +
-            '    z: 9999; source: "' + source + '"; playing: true; cache: false; fillMode: Image.PreserveAspectFit; smooth: true; ' +
-            '}', animManager);
-        console.log('showGifAt: created gif', source, 'at', row, col, 'size', w, h, 'duration', durationMs);
-        var killer = Qt.createQmlObject('import QtQuick 2.15; Timer { interval: ' + (durationMs || 700) + '; repeat: false }', animManager);
-        killer.triggered.connect(function(){ console.log('showGifAt: killer triggered for', source, row, col); if (gif) { try { gif.playing = false; gif.visible = false; gif.source = ""; } catch(e){} try { gif.destroy(); } catch(e){} } });
-        killer.start();
-        // stop playback earlier before destruction to avoid lingering final frames
-        var preStopGap = 160; // 提前多少毫秒开始停止（比之前的 80ms 更早以保证清理完成）
-        var stopperInterval = Math.max(1, (durationMs || 700) - preStopGap);
-        var stopper = Qt.createQmlObject('import QtQuick 2.15; Timer { interval: ' + stopperInterval + '; repeat: false }', animManager);
-        stopper.triggered.connect(function(){
-            console.log('showGifAt: stopper triggered for', source, row, col, 'preStopGap=', preStopGap);
-            try {
-                if (gif) {
-                    // 先立即清空 source 并隐藏，尽量避免渲染出最后一帧
-                    try { gif.source = ""; gif.visible = false; } catch(e){}
-                    // 作为保险，再做一次稍长的 opacity 渐隐，确保渲染管线不会留下残影
-                    var fade = null;
-                    try {
-                        fade = Qt.createQmlObject('import QtQuick 2.15; NumberAnimation { property: "opacity"; duration: 80 }', animManager);
-                        fade.target = gif; fade.to = 0;
-                        fade.onFinished.connect(function(){
-                            try { gif.playing = false; gif.visible = false; if (typeof gif.frame !== 'undefined') gif.frame = 0; } catch(e){}
-                            try { fade.destroy(); } catch(e){}
-                        });
-                        fade.start();
-                    } catch(e) {
-                        // 若创建动画失败，则确保隐藏与停止
-                        try { gif.playing = false; gif.visible = false; if (typeof gif.frame !== 'undefined') gif.frame = 0; } catch(e){}
-                    }
-                }
-            } catch(e){}
-        });
-        stopper.start();
+        // 提前 160ms 停止并清空 source，避免渲染出最后一帧
+        var gif = _playGif(x, y, w, h, source, Image.PreserveAspectFit, durationMs || 700, 160);
+        console.log('showGifAt: gif', source, 'at', row, col, 'size', w, h, 'duration', durationMs);
         return gif;
     }
 
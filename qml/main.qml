@@ -729,9 +729,10 @@ ApplicationWindow {
                 radius: 15
                 border.color: "#34495E"
                 border.width: 3
+                clip: true          // 补位方块从棋盘上方滑入，不画到棋盘区域之外
 
-                property int rows: 8
-                property int cols: 8
+                property int rows: gameBoard ? gameBoard.rows : 8
+                property int cols: gameBoard ? gameBoard.columns : 8
                 property real cellSize: Math.min(width / cols, height / rows)   // 格子尽量正方形
                 property real boardWidth: cols * cellSize
                 property real boardHeight: rows * cellSize
@@ -764,7 +765,7 @@ ApplicationWindow {
                 }
                 Repeater {
                     id: boardRepeater
-                    model: gameArea.rows * gameArea.cols
+                    model: gameBoard ? gameBoard.boardModel : gameArea.rows * gameArea.cols
 
                     Rectangle {
                         id: tileRect
@@ -772,7 +773,7 @@ ApplicationWindow {
                         height: gameArea.cellSize - 2
                         radius: 8
                         border.width: 2
-                        border.color: Qt.lighter(color, 1.2)
+                        border.color: pendingActivation ? "gold" : Qt.lighter(color, 1.2)   // 已被波及、等待连锁激活的道具
 
                         property int row: Math.floor(index / gameArea.cols)
                         property int col: index % gameArea.cols
@@ -782,14 +783,27 @@ ApplicationWindow {
                         x: gameArea.offsetX + col * gameArea.cellSize + offsetX
                         y: gameArea.offsetY + row * gameArea.cellSize + offsetY
 
-                        property string tileColor: (gameBoard ? (gameBoard.tileAt(row, col) === "" ? "transparent" : gameBoard.tileAt(row, col)) : "gray")
+                        // 动画会直接改写 tileColor（打断绑定），所以由 revision 变化把模型里的值写回并复位外观
+                        property string tileColor: gameBoard ? model.tileColor : "gray"
+                        readonly property int revision: gameBoard ? model.revision : 0
+                        readonly property bool pendingActivation: gameBoard ? model.pendingActivation : false
+                        // 下落：模型给出方块起点在落点之上的行数，委托从那里滑落到位
+                        readonly property int dropOffset: gameBoard ? model.dropOffset : 0
+                        onDropOffsetChanged: {
+                            if (dropOffset <= 0) return;
+                            dropAnim.from = -dropOffset * gameArea.cellSize;
+                            dropAnim.duration = animManager.dropDuration(dropOffset);
+                            dropAnim.restart();
+                        }
+                        NumberAnimation { id: dropAnim; target: tileRect; property: "offsetY"; to: 0; easing.type: Easing.OutCubic }
                         property bool isMatched: false
                         color: "transparent"
-                        // 注册到动画管理器
-                        Component.onCompleted: {
-                            if (animManager) {
-                                animManager.tileMap[row + "_" + col] = tileRect;
-                            }
+                        onRevisionChanged: {
+                            tileColor = model.tileColor;
+                            opacity = 1.0;
+                            scale = 1.0;
+                            offsetX = 0;
+                            offsetY = 0;
                         }
                         // 将火箭方块替换为 GIF，其他保持 PNG
                         Item {
@@ -1001,22 +1015,6 @@ ApplicationWindow {
                 if (simpleSfx && simpleSfx.playMatchAudio) simpleSfx.playMatchAudio();
                 animTimer.start()
             }
-            function onBoardChanged() {
-                // 刷新所有tile的颜色并重置视觉状态
-                for (var i = 0; i < 64; i++) {
-                    var item = boardRepeater.itemAt(i);
-                    if (item) {
-                        var newColor = gameBoard.tileAt(item.row, item.col);
-                        if (newColor === "") newColor = "transparent";
-                        item.tileColor = newColor;
-                        // 重置可能残留的动画状态，确保视觉与数据一致
-                        item.opacity = 1.0;
-                        item.scale = 1.0;
-                        item.offsetX = 0;
-                        item.offsetY = 0;
-                    }
-                }
-            }
             function onComboChanged(comboCount) {
                 console.log("onComboChanged:", comboCount);
                 // 更新文字
@@ -1071,7 +1069,16 @@ ApplicationWindow {
                 // runSuperItemEffect(superItemMatches);
             }
 
-            function onPropEffect(row, col, type, color){
+            function onPropBatch(activations) {
+                // 引擎已算完整条连锁：同层并行播放，下一层按 delayMs 建议时间启动
+                for (var i = 0; i < activations.length; i++) {
+                    (function(a) {
+                        if (a.delayMs > 0) animManager.after(a.delayMs, function() { playPropEffect(a.row, a.col, a.type, a.color); });
+                        else playPropEffect(a.row, a.col, a.type, a.color);
+                    })(activations[i]);
+                }
+            }
+            function playPropEffect(row, col, type, color){
                 if (type === 1) {
                     if (simpleSfx && simpleSfx.playPropLimited) simpleSfx.playPropLimited("rocket");
                     console.log("播放火箭激活动画: ", row, col);
@@ -1124,6 +1131,7 @@ ApplicationWindow {
     AnimationManager {
         id: animManager
         boardView: gameArea
+        tileRepeater: boardRepeater
         gameBoard: gameBoardCpp
     }
 